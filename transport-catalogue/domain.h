@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "geo.h"
+#include "span.h"
 
 namespace tc {
 
@@ -25,8 +27,10 @@ namespace tc {
 		double curvature = 0.0;
 	};
 
+	// Названия маршрутов через остановку по возрастанию. Ссылаются на данные справочника
+	// и действительны, пока он не изменён
 	struct StopInfo {
-		std::vector<std::string> buses;
+		util::Span<const std::string_view> buses;
 	};
 
 } // namespace tc
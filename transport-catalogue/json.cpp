@@ -1,6 +1,15 @@
 #include "json.h"
 
-#include <cctype>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <system_error>
+#include <type_traits>
 #include <utility>
 
 using namespace std::literals;
@@ -11,159 +20,229 @@ namespace json {
 
         // ----------------- Print -----------------
 
-        void PrintNode(const Node& node, std::ostream& output, int indent);
-
-        std::string Indent(int indent) {
-            std::string indent_str;
-            for (int i = 0; i < indent; ++i) {
-                indent_str += "    "s;
+        // Возвращает escape-последовательность для символа или пустую строку,
+        // если символ выводится как есть
+        std::string_view Escape(char c) {
+            switch (c) {
+            case '\r':
+                return "\\r"sv;
+            case '\n':
+                return "\\n"sv;
+            case '\"':
+                return "\\\""sv;
+            case '\\':
+                return "\\\\"sv;
+            default:
+                return {};
             }
-            return indent_str;
         }
 
-        void PrintArray(const Array& array, std::ostream& output, int indent) {
-            output << "[\n"s;
-
-            for (size_t i = 0; i < array.size(); ++i) {
-                output << Indent(indent + 1);
-                PrintNode(array[i], output, indent + 1);
-                if (i < array.size() - 1) {
-                    output << ',';
+        // Участки без экранируемых символов выводятся целиком
+        void PrintEscaped(std::string_view str, std::ostream& output) {
+            size_t begin = 0;
+            for (size_t i = 0; i < str.size(); ++i) {
+                if (const auto escaped = Escape(str[i]); !escaped.empty()) {
+                    output.write(str.data() + begin, i - begin);
+                    output.write(escaped.data(), escaped.size());
+                    begin = i + 1;
                 }
-                output << '\n';
             }
+            output.write(str.data() + begin, str.size() - begin);
+        }
 
-            output << Indent(indent) << ']';
+        void PrintString(std::string_view str, std::ostream& output) {
+            output.put('\"');
+            PrintEscaped(str, output);
+            output.put('\"');
         }
 
-        void PrintMap(const Dict& dict, std::ostream& output, int indent) {
-            output << "{\n"s;
+        /*
+         * Буфер потока, который экранирует записанные в него символы и передаёт их в output.
+         * Символы накапливаются в собственном буфере и экранируются блоками при его заполнении
+         * и при вызове sync
+         */
+        class EscapingBuffer : public std::streambuf {
+        public:
+            explicit EscapingBuffer(std::ostream& output)
+                : output_(output) {
+                setp(buffer_, buffer_ + BUFFER_SIZE);
+            }
 
-            size_t i = 0;
-            for (const auto& [key, value] : dict) {
-                output << Indent(indent + 1) << '\"' << key << "\": ";
-                PrintNode(value, output, indent + 1);
-                if (i < dict.size() - 1) {
-                    output << ',';
+        protected:
+            int_type overflow(int_type ch) override {
+                if (sync() != 0) {
+                    return traits_type::eof();
                 }
-                output << '\n';
-                ++i;
+                if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(ch);
+                    pbump(1);
+                }
+                return traits_type::not_eof(ch);
             }
 
-            output << Indent(indent) << '}';
-        }
-
-        void PrintString(const std::string& str, std::ostream& output) {
-            output << '\"';
-            for (char c : str) {
-                switch (c) {
-                case '\r':
-                    output << "\\r";
-                    break;
-                case '\n':
-                    output << "\\n";
-                    break;
-                case '\"':
-                    output << "\\\"";
-                    break;
-                case '\\':
-                    output << "\\\\";
-                    break;
-                default:
-                    output << c;
-                }
+            int sync() override {
+                PrintEscaped(std::string_view(pbase(), pptr() - pbase()), output_);
+                setp(buffer_, buffer_ + BUFFER_SIZE);
+                return output_ ? 0 : -1;
             }
-            output << '\"';
-        }
 
-        void PrintNode(const Node& node, std::ostream& output, int indent) {
+        private:
+            static constexpr size_t BUFFER_SIZE = 4096;
+
+            std::ostream& output_;
+            char buffer_[BUFFER_SIZE];
+        };
+
+        void PrintNode(const Node& node, Writer& writer) {
             if (node.IsArray()) {
-                PrintArray(node.AsArray(), output, indent);
+                writer.StartArray();
+                for (const auto& item : node.AsArray()) {
+                    PrintNode(item, writer);
+                }
+                writer.EndArray();
             }
             else if (node.IsMap()) {
-                PrintMap(node.AsMap(), output, indent);
+                writer.StartDict();
+                for (const auto& [key, value] : node.AsMap()) {
+                    writer.Key(key);
+                    PrintNode(value, writer);
+                }
+                writer.EndDict();
             }
             else if (node.IsString()) {
-                PrintString(node.AsString(), output);
+                writer.Value(node.AsString());
             }
             else if (node.IsNull()) {
-                output << "null";
+                writer.Value(nullptr);
             }
-            else if (node.IsInt()) {
-                output << node.AsInt();
+            else if (node.IsInt64()) {
+                writer.Value(node.AsInt64());
             }
             else if (node.IsPureDouble()) {
-                output << node.AsDouble();
+                writer.Value(node.AsDouble());
             }
             else if (node.IsBool()) {
-                output << std::boolalpha << node.AsBool() << std::noboolalpha;
+                writer.Value(node.AsBool());
             }
         }
 
-        // ----------------- Load -----------------
+        // ----------------- Parse -----------------
 
-        void MoveToToken(std::istream& input) {
-            auto read_char = [&input] {
-                char c = static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-                return c;
-            };
+        bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
 
-            char c = ' ';
-            while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-                c = read_char();
-                if (c == '\\') {
-                    c = read_char();
-                    switch (c) {
-                    case 't':
-                        c = '\t';
-                        break;
-                    case 'n':
-                        c = '\n';
-                        break;
-                    case 'r':
-                        c = '\r';
-                        break;
-                    default:
-                        input.putback(c);
-                    }
-                }
-            }
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
 
-            input.putback(c);
+        // Возвращает символ, обозначаемый escape-последовательностью \escaped_char
+        char Unescape(char escaped_char) {
+            // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+            switch (escaped_char) {
+            case 'n':
+                return '\n';
+            case 't':
+                return '\t';
+            case 'r':
+                return '\r';
+            case '"':
+                return '"';
+            case '\\':
+                return '\\';
+            default:
+                // Встретили неизвестную escape-последовательность
+                throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            }
         }
 
-        Node LoadNode(std::istream& input);
+        // Базовый класс приёмников событий, которым нужны границы значений и ключей в тексте
+        // документа: парсер сообщает им начало и конец каждого токена и не преобразует числа
+        struct TokenSink {
+        };
+
+        template <typename Sink>
+        constexpr bool IS_TOKEN_SINK = std::is_base_of_v<TokenSink, Sink>;
+
+        // Разбирает JSON-документ, целиком размещённый в непрерывном буфере, и сообщает
+        // о прочитанных элементах обработчику Sink (интерфейс совпадает с json::Handler).
+        // Текущая позиция хранится в виде указателя, поэтому чтение символа
+        // не требует обращения к потоку
+        template <typename Sink>
+        class Parser {
+        public:
+            Parser(std::string_view input, Sink& sink)
+                : pos_(input.data())
+                , end_(input.data() + input.size())
+                , sink_(sink) {
+            }
+
+            void ParseValue();
+
+        private:
+            const char* pos_;
+            const char* end_;
+            Sink& sink_;
+            // Буфер для строк, содержащих escape-последовательности
+            std::string unescaped_;
+
+            // Возвращает текущий символ, не сдвигая позицию, или '\0' в конце буфера
+            char Peek() const {
+                return pos_ != end_ ? *pos_ : '\0';
+            }
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
+            void MoveToToken();
 
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
+            void ParseNumber();
+            std::string_view ParseString();
+            void ParseNull();
+            void ParseBool();
+            void ParseArray();
+            void ParseDict();
+        };
+
+        // Пропускает пробельные символы, в том числе экранированные \t, \n и \r.
+        // После вызова pos_ указывает на первый символ очередного токена
+        template <typename Sink>
+        void Parser<Sink>::MoveToToken() {
+            while (true) {
+                if (pos_ == end_) {
+                    throw ParsingError("Unexpected end of document"s);
                 }
-            };
 
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
+                const char c = *pos_;
+                if (IsSpace(c)) {
+                    ++pos_;
+                }
+                else if (c == '\\' && end_ - pos_ > 1 && (pos_[1] == 't' || pos_[1] == 'n' || pos_[1] == 'r')) {
+                    pos_ += 2;
+                }
+                else {
+                    return;
+                }
+            }
+        }
+
+        template <typename Sink>
+        void Parser<Sink>::ParseNumber() {
+            const char* const start = pos_;
+
+            // Пропускает одну или более цифр
+            const auto read_digits = [this] {
+                if (!IsDigit(Peek())) {
                     throw ParsingError("A digit is expected"s);
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                while (IsDigit(Peek())) {
+                    ++pos_;
                 }
             };
 
-            if (input.peek() == '-') {
-                read_char();
+            if (Peek() == '-') {
+                ++pos_;
             }
             // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
+            if (Peek() == '0') {
+                ++pos_;
                 // После 0 в JSON не могут идти другие цифры
             }
             else {
@@ -172,284 +251,854 @@ namespace json {
 
             bool is_int = true;
             // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
+            if (Peek() == '.') {
+                ++pos_;
                 read_digits();
                 is_int = false;
             }
 
             // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+            if (char ch = Peek(); ch == 'e' || ch == 'E') {
+                ++pos_;
+                if (ch = Peek(); ch == '+' || ch == '-') {
+                    ++pos_;
                 }
                 read_digits();
                 is_int = false;
             }
 
-            try {
+            if constexpr (IS_TOKEN_SINK<Sink>) {
+                // Число будет преобразовано при обращении к нему
+                sink_.Number();
+            }
+            else {
+                // Число преобразуется прямо из входного буфера, без копирования и исключений
                 if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return Node(std::stoi(parsed_num));
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении,
-                        // код ниже попробует преобразовать строку в double
+                    // Сначала пробуем преобразовать строку в int64_t
+                    std::int64_t value = 0;
+                    if (std::from_chars(start, pos_, value).ec == std::errc{}) {
+                        sink_.Int(value);
+                        return;
                     }
+                    // В случае переполнения код ниже преобразует строку в double
                 }
-                return Node(std::stod(parsed_num));
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+
+                double value = 0.0;
+                if (std::from_chars(start, pos_, value).ec != std::errc{}) {
+                    throw ParsingError("Failed to convert "s + std::string(start, pos_) + " to number"s);
+                }
+                sink_.Double(value);
             }
         }
 
         // Считывает содержимое строкового литерала JSON-документа
         // Функцию следует использовать после считывания открывающего символа ":
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
+        // Строка без escape-последовательностей возвращается в виде ссылки на входной буфер,
+        // остальные строки - в виде ссылки на unescaped_, действительной до следующего вызова
+        template <typename Sink>
+        std::string_view Parser<Sink>::ParseString() {
+            // Участок без кавычек, escape-последовательностей и переводов строки пропускаем целиком
+            const auto skip_plain_chars = [this] {
+                while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\' && *pos_ != '\n' && *pos_ != '\r') {
+                    ++pos_;
+                }
+            };
+
+            const char* const begin = pos_;
+            skip_plain_chars();
+            if (pos_ != end_ && *pos_ == '"') {
+                ++pos_;
+                return std::string_view(begin, pos_ - begin - 1);
+            }
+
+            unescaped_.assign(begin, pos_);
             while (true) {
-                if (it == end) {
-                    // Поток закончился до того, как встретили закрывающую кавычку?
+                if (pos_ == end_) {
+                    // Буфер закончился до того, как встретили закрывающую кавычку?
                     throw ParsingError("String parsing error");
                 }
-                const char ch = *it;
+
+                const char ch = *pos_++;
                 if (ch == '"') {
                     // Встретили закрывающую кавычку
-                    ++it;
                     break;
                 }
                 else if (ch == '\\') {
                     // Встретили начало escape-последовательности
-                    ++it;
-                    if (it == end) {
-                        // Поток завершился сразу после символа обратной косой черты
+                    if (pos_ == end_) {
+                        // Буфер завершился сразу после символа обратной косой черты
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
-                    // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-                    switch (escaped_char) {
-                    case 'n':
-                        s.push_back('\n');
-                        break;
-                    case 't':
-                        s.push_back('\t');
-                        break;
-                    case 'r':
-                        s.push_back('\r');
-                        break;
-                    case '"':
-                        s.push_back('"');
-                        break;
-                    case '\\':
-                        s.push_back('\\');
-                        break;
-                    default:
-                        // Встретили неизвестную escape-последовательность
-                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-                    }
-                }
-                else if (ch == '\n' || ch == '\r') {
-                    // Строковый литерал внутри- JSON не может прерываться символами \r или \n
-                    throw ParsingError("Unexpected end of line"s);
+                    unescaped_.push_back(Unescape(*pos_++));
                 }
                 else {
-                    // Просто считываем очередной символ и помещаем его в результирующую строку
-                    s.push_back(ch);
+                    // Строковый литерал внутри JSON не может прерываться символами \r или \n
+                    throw ParsingError("Unexpected end of line"s);
                 }
-                ++it;
+
+                const char* const chunk_begin = pos_;
+                skip_plain_chars();
+                unescaped_.append(chunk_begin, pos_);
             }
 
-            return Node(s);
+            return unescaped_;
         }
 
         // предполагается, что 1-я буква 'n' уже успешно прочитана
-        Node LoadNull(std::istream& input) {
-            std::string null_str;
-            for (int i = 0; i < 3; ++i) {
-                null_str += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read null from stream"s);
-                }
+        template <typename Sink>
+        void Parser<Sink>::ParseNull() {
+            const auto rest = "ull"sv;
+            if (static_cast<size_t>(end_ - pos_) < rest.size()) {
+                throw ParsingError("Failed to read null from stream"s);
             }
-
-            if (null_str != "ull") {
+            if (std::string_view(pos_, rest.size()) != rest) {
                 throw ParsingError("Invalid null token"s);
             }
+            pos_ += rest.size();
 
-            return Node();
+            sink_.Null();
         }
 
-        // предполагается, что можно корректно прочитать 1-ю букву, и она равна 't' или 'f'
-        Node LoadBool(std::istream& input) {
-            std::string bool_str;
-
-            const auto read_chars = [&bool_str, &input](int n) {
-                for (int i = 0; i < n; ++i) {
-                    bool_str += static_cast<char>(input.get());
-                    if (!input) {
-                        throw ParsingError("Failed to read bool from stream"s);
-                    }
-                }
-            };
-
-            bool_str += static_cast<char>(input.get());
-            if (bool_str == "t"s) {
-                //пробуем считать "rue"
-                read_chars(3);
-                if (bool_str != "true"s) {
-                    throw ParsingError("Invalid bool token"s);
-                }
-                return Node(true);
-
+        // предполагается, что текущая буква равна 't' или 'f'
+        template <typename Sink>
+        void Parser<Sink>::ParseBool() {
+            const bool value = *pos_ == 't';
+            const auto literal = value ? "true"sv : "false"sv;
+            if (static_cast<size_t>(end_ - pos_) < literal.size()) {
+                throw ParsingError("Failed to read bool from stream"s);
             }
-            else {
-                //пробуем считать "alse"
-                read_chars(4);
-                if (bool_str != "false"s) {
-                    throw ParsingError("Invalid bool token"s);
-                }
-                return Node(false);
+            if (std::string_view(pos_, literal.size()) != literal) {
+                throw ParsingError("Invalid bool token"s);
             }
+            pos_ += literal.size();
+
+            sink_.Bool(value);
         }
 
         // символ '[' уже прочитан
-        Node LoadArray(std::istream& input) {
-            Array result;
-
-            MoveToToken(input);
-            char c = static_cast<char>(input.get());
-            if (c == ']') {
-                return Node(std::move(result));
+        template <typename Sink>
+        void Parser<Sink>::ParseArray() {
+            sink_.StartArray();
+
+            MoveToToken();
+            if (*pos_ == ']') {
+                ++pos_;
+                sink_.EndArray();
+                return;
             }
 
-            input.putback(c);
-
-            while (c != ']') {
-                result.push_back(LoadNode(input));
+            while (true) {
+                ParseValue();
 
-                MoveToToken(input);
-                c = static_cast<char>(input.get());
-                if (!(c == ',' || c == ']')) {
+                MoveToToken();
+                const char c = *pos_++;
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
                     throw ParsingError("Failed to load array: ',' or ']' is missing"s);
                 }
             }
 
-            return Node(std::move(result));
+            sink_.EndArray();
         }
 
         // символ '{' уже прочитан
-        Node LoadDict(std::istream& input) {
-            Dict result;
-
-            MoveToToken(input);
-            char c = static_cast<char>(input.get());
-            if (c == '}') {
-                return Node(std::move(result));
+        template <typename Sink>
+        void Parser<Sink>::ParseDict() {
+            sink_.StartDict();
+
+            MoveToToken();
+            if (*pos_ == '}') {
+                ++pos_;
+                sink_.EndDict();
+                return;
             }
 
-            input.putback(c);
-
-            while (c != '}') {
-                auto node_key = LoadNode(input);
-                if (!node_key.IsString()) {
+            while (true) {
+                MoveToToken();
+                if constexpr (IS_TOKEN_SINK<Sink>) {
+                    sink_.TokenBegin(pos_);
+                }
+                if (*pos_++ != '"') {
                     throw ParsingError("Failed to load dict key"s);
                 }
+                sink_.Key(ParseString());
+                if constexpr (IS_TOKEN_SINK<Sink>) {
+                    sink_.TokenEnd(pos_);
+                }
 
-                MoveToToken(input);
-                c = static_cast<char>(input.get());
-                if (c != ':') {
+                MoveToToken();
+                if (*pos_++ != ':') {
                     throw ParsingError("Failed to load dict: ':' is missing"s);
                 }
 
-                Node value = LoadNode(input);
-
-                result.emplace(node_key.AsString(), std::move(value));
+                ParseValue();
 
-                MoveToToken(input);
-                c = static_cast<char>(input.get());
-                if (!(c == ',' || c == '}')) {
+                MoveToToken();
+                const char c = *pos_++;
+                if (c == '}') {
+                    break;
+                }
+                if (c != ',') {
                     throw ParsingError("Failed to load dict: ',' or '}' is missing"s);
                 }
             }
 
-            return Node(std::move(result));
+            sink_.EndDict();
         }
 
-        Node LoadNode(std::istream& input) {
-            MoveToToken(input);
-            char c = static_cast<char>(input.get());
+        template <typename Sink>
+        void Parser<Sink>::ParseValue() {
+            MoveToToken();
+            const char c = *pos_;
+            if constexpr (IS_TOKEN_SINK<Sink>) {
+                sink_.TokenBegin(pos_);
+            }
 
             if (c == '[') {
-                return LoadArray(input);
+                ++pos_;
+                ParseArray();
             }
             else if (c == '{') {
-                return LoadDict(input);
+                ++pos_;
+                ParseDict();
             }
             else if (c == '"') {
-                return LoadString(input);
+                ++pos_;
+                sink_.String(ParseString());
             }
-            else if (c == '-' || std::isdigit(c)) {
-                input.putback(c);
-                return LoadNumber(input);
+            else if (c == '-' || IsDigit(c)) {
+                ParseNumber();
             }
             else if (c == 'n') {
-                return LoadNull(input);
+                ++pos_;
+                ParseNull();
             }
             else if (c == 't' || c == 'f') {
-                input.putback(c);
-                return LoadBool(input);
+                ParseBool();
             }
             else {
                 throw ParsingError("Unknown token"s);
             }
+
+            if constexpr (IS_TOKEN_SINK<Sink>) {
+                sink_.TokenEnd(pos_);
+            }
+        }
+
+        // ----------------- Load -----------------
+
+        // Собирает дерево Node из событий парсера, размещая строки и контейнеры в resource.
+        // Элементы незавершённых контейнеров накапливаются во временных буферах, которые
+        // переиспользуются для всех контейнеров одного уровня вложенности, поэтому
+        // в resource попадают только контейнеры точного размера
+        class TreeBuilder {
+        public:
+            explicit TreeBuilder(std::pmr::memory_resource* resource)
+                : resource_(resource) {
+            }
+
+            void Null() {
+                AddValue(Node());
+            }
+
+            void Bool(bool value) {
+                AddValue(Node(value));
+            }
+
+            void Int(std::int64_t value) {
+                AddValue(Node(value));
+            }
+
+            void Double(double value) {
+                AddValue(Node(value));
+            }
+
+            void String(std::string_view value) {
+                AddValue(Node(value, resource_));
+            }
+
+            void StartArray() {
+                PushFrame().is_dict = false;
+            }
+
+            void EndArray() {
+                auto& items = stack_[depth_ - 1].array;
+                Array array(resource_);
+                array.reserve(items.size());
+                std::move(items.begin(), items.end(), std::back_inserter(array));
+                items.clear();
+
+                --depth_;
+                AddValue(Node(std::move(array)));
+            }
+
+            void StartDict() {
+                PushFrame().is_dict = true;
+            }
+
+            void Key(std::string_view key) {
+                stack_[depth_ - 1].key = json::String(key, resource_);
+            }
+
+            void EndDict() {
+                auto& items = stack_[depth_ - 1].items;
+                Dict::Items dict_items(resource_);
+                dict_items.reserve(items.size());
+                std::move(items.begin(), items.end(), std::back_inserter(dict_items));
+                items.clear();
+
+                --depth_;
+                AddValue(Node(Dict(std::move(dict_items))));
+            }
+
+            Node ExtractRoot() {
+                return std::move(root_);
+            }
+
+        private:
+            // Контейнер, заполнение которого ещё не завершено
+            struct Frame {
+                bool is_dict = false;
+                std::vector<Node> array;
+                std::vector<Dict::value_type> items;
+                json::String key;
+            };
+
+            std::pmr::memory_resource* resource_;
+            std::vector<Frame> stack_;
+            size_t depth_ = 0;
+            Node root_;
+
+            Frame& PushFrame() {
+                if (depth_ == stack_.size()) {
+                    stack_.emplace_back();
+                }
+                return stack_[depth_++];
+            }
+
+            void AddValue(Node value) {
+                if (depth_ == 0) {
+                    root_ = std::move(value);
+                    return;
+                }
+
+                auto& frame = stack_[depth_ - 1];
+                if (frame.is_dict) {
+                    frame.items.emplace_back(std::move(frame.key), std::move(value));
+                }
+                else {
+                    frame.array.push_back(std::move(value));
+                }
+            }
+        };
+
+        // ----------------- LoadLazy -----------------
+
+        // Записывает в ленту тип и положение в тексте каждого значения и ключа документа
+        class TapeBuilder : public TokenSink {
+        public:
+            using Token = LazyDocument::Token;
+
+            explicit TapeBuilder(std::string_view input)
+                : input_(input) {
+            }
+
+            void TokenBegin(const char* pos) {
+                begin_ = static_cast<uint64_t>(pos - input_.data());
+            }
+
+            // Вызывается после значения или ключа, добавленного (завершённого) последним
+            void TokenEnd(const char* pos) {
+                tape_[last_].SetEnd(static_cast<uint64_t>(pos - input_.data()));
+            }
+
+            void Null() {
+                Add(Token::Type::NONE);
+            }
+
+            void Bool(bool) {
+                Add(Token::Type::BOOL);
+            }
+
+            void Number() {
+                Add(Token::Type::NUMBER);
+            }
+
+            void String(std::string_view value) {
+                Add(Token::Type::STRING).escaped = HasEscapes(value);
+            }
+
+            void StartArray() {
+                Add(Token::Type::ARRAY);
+                open_.push_back(last_);
+            }
+
+            void EndArray() {
+                EndContainer();
+            }
+
+            void StartDict() {
+                Add(Token::Type::DICT);
+                open_.push_back(last_);
+            }
+
+            void Key(std::string_view key) {
+                // Размер словаря считается по ключам, значения в нём не учитываются
+                ++tape_[open_.back()].size;
+                AddToken(Token::Type::STRING).escaped = HasEscapes(key);
+            }
+
+            void EndDict() {
+                EndContainer();
+            }
+
+            std::vector<Token> ExtractTape() {
+                return std::move(tape_);
+            }
+
+        private:
+            std::string_view input_;
+            std::vector<Token> tape_;
+            // Номера незавершённых контейнеров
+            std::vector<uint32_t> open_;
+            uint64_t begin_ = 0;
+            uint32_t last_ = 0;
+
+            // Строки без escape-последовательностей парсер возвращает в виде ссылки на входной текст
+            bool HasEscapes(std::string_view value) const {
+                const std::less<const char*> less;
+                return less(value.data(), input_.data()) || less(input_.data() + input_.size(), value.data());
+            }
+
+            Token& Add(Token::Type type) {
+                if (!open_.empty() && tape_[open_.back()].type == Token::Type::ARRAY) {
+                    ++tape_[open_.back()].size;
+                }
+                return AddToken(type);
+            }
+
+            Token& AddToken(Token::Type type) {
+                // Номера токенов и их число в контейнере хранятся в 32 битах
+                if (tape_.size() == std::numeric_limits<uint32_t>::max()) {
+                    throw ParsingError("Document is too large"s);
+                }
+                last_ = static_cast<uint32_t>(tape_.size());
+                Token& token = tape_.emplace_back();
+                token.type = type;
+                token.SetBegin(begin_);
+                return token;
+            }
+
+            void EndContainer() {
+                last_ = open_.back();
+                open_.pop_back();
+                tape_[last_].span = static_cast<uint32_t>(tape_.size()) - last_;
+            }
+        };
+
+        bool IsIntegerToken(std::string_view text) {
+            return text.find_first_of(".eE"sv) == std::string_view::npos;
+        }
+
+        // Размещает копию объекта в ресурсе памяти, из которого выделяет память сам объект
+        template <typename Container>
+        Container* NewInOwnResource(Container&& container) {
+            std::pmr::memory_resource* resource = container.get_allocator().resource();
+            void* ptr = resource->allocate(sizeof(Container), alignof(Container));
+            return new (ptr) Container(std::move(container));
+        }
+
+        template <typename Container>
+        void DeleteFromOwnResource(Container* container) noexcept {
+            std::pmr::memory_resource* resource = container->get_allocator().resource();
+            container->~Container();
+            resource->deallocate(container, sizeof(Container), alignof(Container));
+        }
+
+        Array CopyArray(const Array& array, std::pmr::memory_resource* resource) {
+            Array result(resource);
+            result.reserve(array.size());
+            for (const auto& item : array) {
+                result.emplace_back(item, resource);
+            }
+            return result;
+        }
+
+        Array MoveArray(Array& array, std::pmr::memory_resource* resource) {
+            if (*array.get_allocator().resource() == *resource) {
+                return std::move(array);
+            }
+            Array result(resource);
+            result.reserve(array.size());
+            for (auto& item : array) {
+                result.emplace_back(std::move(item), resource);
+            }
+            return result;
+        }
+
+        bool KeyLess(const Dict::value_type& lhs, const Dict::value_type& rhs) {
+            return std::string_view(lhs.first) < std::string_view(rhs.first);
         }
 
     }  // namespace
 
-    Node::Node(nullptr_t) {}
-    Node::Node(int value) : value_(value) {}
-    Node::Node(double value) : value_(value) {}
-    Node::Node(std::string value) : value_(std::move(value)) {}
-    Node::Node(bool value) : value_(value) {}
-    Node::Node(Array array) : value_(std::move(array)) {}
-    Node::Node(Dict map) : value_(std::move(map)) {}
-    Node::Node(Value value) : value_(std::move(value)) {}
+    // ----------------- String -----------------
+
+    String::String() noexcept {
+        bytes_[SHORT_CAPACITY] = 0;
+    }
+
+    String::String(std::string_view value, std::pmr::memory_resource* resource) {
+        Assign(value, resource);
+    }
+
+    String::String(const String& other)
+        : String(other, std::pmr::get_default_resource()) {
+    }
+
+    String::String(const String& other, std::pmr::memory_resource* resource) {
+        Assign(other, resource);
+    }
+
+    String::String(String&& other) noexcept {
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        other.bytes_[SHORT_CAPACITY] = 0;
+    }
+
+    String::String(String&& other, std::pmr::memory_resource* resource) {
+        if (other.IsLong() && *other.LongResource() != *resource) {
+            Assign(other, resource);
+        }
+        else {
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            other.bytes_[SHORT_CAPACITY] = 0;
+        }
+    }
+
+    String::~String() {
+        Release();
+    }
+
+    String& String::operator=(const String& other) {
+        if (this != &other) {
+            String copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    String& String::operator=(String&& other) noexcept {
+        if (this != &other) {
+            Release();
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            other.bytes_[SHORT_CAPACITY] = 0;
+        }
+        return *this;
+    }
+
+    const char* String::data() const noexcept {
+        return IsLong() ? LongBlock() + sizeof(std::pmr::memory_resource*) : bytes_;
+    }
+
+    size_t String::size() const noexcept {
+        if (!IsLong()) {
+            return static_cast<unsigned char>(bytes_[SHORT_CAPACITY]);
+        }
+        uint32_t size = 0;
+        std::memcpy(&size, bytes_ + sizeof(char*), sizeof(size));
+        return size;
+    }
+
+    bool String::IsLong() const noexcept {
+        return static_cast<unsigned char>(bytes_[SHORT_CAPACITY]) == LONG_MARKER;
+    }
+
+    char* String::LongBlock() const noexcept {
+        char* block = nullptr;
+        std::memcpy(&block, bytes_, sizeof(block));
+        return block;
+    }
+
+    std::pmr::memory_resource* String::LongResource() const noexcept {
+        std::pmr::memory_resource* resource = nullptr;
+        std::memcpy(&resource, LongBlock(), sizeof(resource));
+        return resource;
+    }
+
+    void String::Assign(std::string_view value, std::pmr::memory_resource* resource) {
+        if (value.size() <= SHORT_CAPACITY) {
+            std::memcpy(bytes_, value.data(), value.size());
+            bytes_[SHORT_CAPACITY] = static_cast<char>(value.size());
+            return;
+        }
+        if (value.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("String is too long"s);
+        }
+
+        const size_t block_size = sizeof(resource) + value.size();
+        char* block = static_cast<char*>(resource->allocate(block_size, alignof(std::pmr::memory_resource*)));
+        std::memcpy(block, &resource, sizeof(resource));
+        std::memcpy(block + sizeof(resource), value.data(), value.size());
+
+        const uint32_t size = static_cast<uint32_t>(value.size());
+        std::memcpy(bytes_, &block, sizeof(block));
+        std::memcpy(bytes_ + sizeof(block), &size, sizeof(size));
+        bytes_[SHORT_CAPACITY] = static_cast<char>(LONG_MARKER);
+    }
+
+    void String::Release() noexcept {
+        if (!IsLong()) {
+            return;
+        }
+        LongResource()->deallocate(LongBlock(), sizeof(std::pmr::memory_resource*) + size(), alignof(std::pmr::memory_resource*));
+        bytes_[SHORT_CAPACITY] = 0;
+    }
+
+    bool operator==(const String& lhs, const String& rhs) {
+        return std::string_view(lhs) == std::string_view(rhs);
+    }
+
+    bool operator!=(const String& lhs, const String& rhs) {
+        return !(lhs == rhs);
+    }
+
+    bool operator<(const String& lhs, const String& rhs) {
+        return std::string_view(lhs) < std::string_view(rhs);
+    }
+
+    // ----------------- Node -----------------
+
+    Node::Node() noexcept
+        : int_(0)
+        , type_(Type::NONE) {
+    }
+
+    Node::Node(const Node& other)
+        : Node(other, std::pmr::get_default_resource()) {
+    }
+
+    Node::Node(Node&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    Node::Node(const Node& other, std::pmr::memory_resource* resource)
+        : int_(0)
+        , type_(other.type_) {
+        switch (type_) {
+        case Type::STRING:
+            new (&string_) String(other.string_, resource);
+            break;
+        case Type::ARRAY:
+            array_ = NewInOwnResource(CopyArray(*other.array_, resource));
+            break;
+        case Type::DICT:
+            dict_ = NewInOwnResource(Dict(*other.dict_, resource));
+            break;
+        case Type::DOUBLE:
+            double_ = other.double_;
+            break;
+        case Type::INT:
+            int_ = other.int_;
+            break;
+        case Type::INT64:
+            int64_ = other.int64_;
+            break;
+        case Type::BOOL:
+            bool_ = other.bool_;
+            break;
+        case Type::NONE:
+            break;
+        }
+    }
+
+    Node::Node(Node&& other, std::pmr::memory_resource* resource)
+        : int_(0)
+        , type_(Type::NONE) {
+        switch (other.type_) {
+        case Type::STRING:
+            new (&string_) String(std::move(other.string_), resource);
+            type_ = Type::STRING;
+            break;
+        case Type::ARRAY:
+            if (*other.array_->get_allocator().resource() == *resource) {
+                MoveFrom(other);
+            }
+            else {
+                array_ = NewInOwnResource(MoveArray(*other.array_, resource));
+                type_ = Type::ARRAY;
+            }
+            break;
+        case Type::DICT:
+            if (*other.dict_->get_allocator().resource() == *resource) {
+                MoveFrom(other);
+            }
+            else {
+                dict_ = NewInOwnResource(Dict(std::move(*other.dict_), resource));
+                type_ = Type::DICT;
+            }
+            break;
+        default:
+            MoveFrom(other);
+        }
+    }
+
+    Node::Node(nullptr_t) noexcept
+        : Node() {
+    }
+
+    Node::Node(int value) noexcept
+        : int_(value)
+        , type_(Type::INT) {
+    }
+
+    Node::Node(std::int64_t value) noexcept
+        : int64_(value)
+        , type_(Type::INT64) {
+        if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+            int_ = static_cast<int>(value);
+            type_ = Type::INT;
+        }
+    }
+
+    Node::Node(double value) noexcept
+        : double_(value)
+        , type_(Type::DOUBLE) {
+    }
+
+    Node::Node(std::string_view value, std::pmr::memory_resource* resource)
+        : string_(value, resource)
+        , type_(Type::STRING) {
+    }
+
+    Node::Node(const std::string& value)
+        : Node(std::string_view(value)) {
+    }
+
+    Node::Node(String value) noexcept
+        : string_(std::move(value))
+        , type_(Type::STRING) {
+    }
+
+    Node::Node(bool value) noexcept
+        : bool_(value)
+        , type_(Type::BOOL) {
+    }
+
+    Node::Node(Array array)
+        : array_(NewInOwnResource(std::move(array)))
+        , type_(Type::ARRAY) {
+    }
+
+    Node::Node(Dict map)
+        : dict_(NewInOwnResource(std::move(map)))
+        , type_(Type::DICT) {
+    }
+
+    Node::~Node() {
+        Destroy();
+    }
+
+    Node& Node::operator=(const Node& other) {
+        if (this != &other) {
+            Node copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    Node& Node::operator=(Node&& other) noexcept {
+        if (this != &other) {
+            Destroy();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    // Переносит значение other в неинициализированный узел, оставляя в other значение null
+    void Node::MoveFrom(Node& other) noexcept {
+        type_ = other.type_;
+        switch (type_) {
+        case Type::STRING:
+            new (&string_) String(std::move(other.string_));
+            other.string_.~String();
+            break;
+        case Type::ARRAY:
+            array_ = other.array_;
+            break;
+        case Type::DICT:
+            dict_ = other.dict_;
+            break;
+        case Type::DOUBLE:
+            double_ = other.double_;
+            break;
+        case Type::INT:
+            int_ = other.int_;
+            break;
+        case Type::INT64:
+            int64_ = other.int64_;
+            break;
+        case Type::BOOL:
+            bool_ = other.bool_;
+            break;
+        case Type::NONE:
+            break;
+        }
+        other.type_ = Type::NONE;
+    }
+
+    void Node::Destroy() noexcept {
+        switch (type_) {
+        case Type::STRING:
+            string_.~String();
+            break;
+        case Type::ARRAY:
+            DeleteFromOwnResource(array_);
+            break;
+        case Type::DICT:
+            DeleteFromOwnResource(dict_);
+            break;
+        default:
+            break;
+        }
+        type_ = Type::NONE;
+    }
 
     bool Node::IsNull() const {
-        return std::holds_alternative<nullptr_t>(value_);
+        return type_ == Type::NONE;
     }
 
     bool Node::IsInt() const {
-        return std::holds_alternative<int>(value_);
+        return type_ == Type::INT;
+    }
+
+    bool Node::IsInt64() const {
+        return type_ == Type::INT || type_ == Type::INT64;
     }
 
     bool Node::IsDouble() const {
-        return std::holds_alternative<int>(value_) || std::holds_alternative<double>(value_);
+        return IsInt64() || type_ == Type::DOUBLE;
     }
 
     bool Node::IsBool() const {
-        return std::holds_alternative<bool>(value_);
+        return type_ == Type::BOOL;
     }
 
     bool Node::IsPureDouble() const {
-        return std::holds_alternative<double>(value_);
+        return type_ == Type::DOUBLE;
     }
 
     bool Node::IsString() const {
-        return std::holds_alternative<std::string>(value_);
+        return type_ == Type::STRING;
     }
 
     bool Node::IsArray() const {
-        return std::holds_alternative<Array>(value_);
+        return type_ == Type::ARRAY;
     }
 
     bool Node::IsMap() const {
-        return std::holds_alternative<Dict>(value_);
+        return type_ == Type::DICT;
     }
 
     std::logic_error Node::TypeMismatchException() {
@@ -460,14 +1109,21 @@ namespace json {
         if (!IsInt()) {
             throw TypeMismatchException();
         }
-        return std::get<int>(value_);
+        return int_;
+    }
+
+    std::int64_t Node::AsInt64() const {
+        if (!IsInt64()) {
+            throw TypeMismatchException();
+        }
+        return type_ == Type::INT ? int_ : int64_;
     }
 
     bool Node::AsBool() const {
         if (!IsBool()) {
             throw TypeMismatchException();
         }
-        return std::get<bool>(value_);
+        return bool_;
     }
 
     double Node::AsDouble() const {
@@ -476,42 +1132,184 @@ namespace json {
         }
 
         if (IsPureDouble()) {
-            return std::get<double>(value_);
+            return double_;
         }
         else {
-            return AsInt();
+            return static_cast<double>(AsInt64());
         }
     }
 
-    const std::string& Node::AsString() const {
+    std::string_view Node::AsString() const {
         if (!IsString()) {
             throw TypeMismatchException();
         }
-        return std::get<std::string>(value_);
+        return string_;
     }
 
     const Array& Node::AsArray() const {
         if (!IsArray()) {
             throw TypeMismatchException();
         }
-        return std::get<Array>(value_);
+        return *array_;
     }
 
     const Dict& Node::AsMap() const {
         if (!IsMap()) {
             throw TypeMismatchException();
         }
-        return std::get<Dict>(value_);
+        return *dict_;
     }
 
     bool Node::operator==(const Node& other) const {
-        return value_ == other.value_;
+        if (type_ != other.type_) {
+            return false;
+        }
+
+        switch (type_) {
+        case Type::STRING:
+            return string_ == other.string_;
+        case Type::ARRAY:
+            return *array_ == *other.array_;
+        case Type::DICT:
+            return *dict_ == *other.dict_;
+        case Type::DOUBLE:
+            return double_ == other.double_;
+        case Type::INT:
+            return int_ == other.int_;
+        case Type::INT64:
+            return int64_ == other.int64_;
+        case Type::BOOL:
+            return bool_ == other.bool_;
+        default:
+            return true;
+        }
     }
 
     bool Node::operator!=(const Node& other) const {
         return !(*this == other);
     }
 
+    // ----------------- Dict -----------------
+
+    Dict::Dict(std::pmr::memory_resource* resource)
+        : items_(resource) {
+    }
+
+    Dict::Dict(Items items)
+        : items_(std::move(items)) {
+        // Элементы уже упорядочены по возрастанию ключей и не содержат повторов
+        const auto not_less = [](const value_type& lhs, const value_type& rhs) {
+            return !KeyLess(lhs, rhs);
+        };
+        if (std::adjacent_find(items_.begin(), items_.end(), not_less) == items_.end()) {
+            return;
+        }
+
+        // Небольшие словари сортируем вставками: в отличие от std::stable_sort,
+        // такая сортировка не выделяет временный буфер
+        const size_t insertion_sort_limit = 32;
+        if (items_.size() <= insertion_sort_limit) {
+            for (auto it = items_.begin() + 1; it != items_.end(); ++it) {
+                std::rotate(std::upper_bound(items_.begin(), it, *it, KeyLess), it, it + 1);
+            }
+        }
+        else {
+            std::stable_sort(items_.begin(), items_.end(), KeyLess);
+        }
+
+        const auto same_key = [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first == rhs.first;
+        };
+        items_.erase(std::unique(items_.begin(), items_.end(), same_key), items_.end());
+    }
+
+    Dict::Dict(std::initializer_list<std::pair<std::string_view, Node>> items) {
+        for (const auto& [key, value] : items) {
+            emplace(key, value);
+        }
+    }
+
+    Dict::Dict(const Dict& other, std::pmr::memory_resource* resource)
+        : items_(resource) {
+        items_.reserve(other.items_.size());
+        for (const auto& [key, value] : other.items_) {
+            items_.emplace_back(String(key, resource), Node(value, resource));
+        }
+    }
+
+    Dict::Dict(Dict&& other, std::pmr::memory_resource* resource)
+        : items_(resource) {
+        items_.reserve(other.items_.size());
+        for (auto& [key, value] : other.items_) {
+            items_.emplace_back(String(std::move(key), resource), Node(std::move(value), resource));
+        }
+    }
+
+    Dict::const_iterator Dict::begin() const {
+        return items_.begin();
+    }
+
+    Dict::const_iterator Dict::end() const {
+        return items_.end();
+    }
+
+    size_t Dict::size() const {
+        return items_.size();
+    }
+
+    bool Dict::empty() const {
+        return items_.empty();
+    }
+
+    Dict::const_iterator Dict::find(std::string_view key) const {
+        const auto it = std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+            return std::string_view(item.first) < key;
+        });
+        if (it != items_.end() && std::string_view(it->first) == key) {
+            return it;
+        }
+        return items_.end();
+    }
+
+    size_t Dict::count(std::string_view key) const {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    const Node& Dict::at(std::string_view key) const {
+        const auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("Key not found"s);
+        }
+        return it->second;
+    }
+
+    std::pair<Dict::const_iterator, bool> Dict::emplace(std::string_view key, Node value) {
+        const auto it = std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+            return std::string_view(item.first) < key;
+        });
+        if (it != items_.end() && std::string_view(it->first) == key) {
+            return { it, false };
+        }
+
+        std::pmr::memory_resource* resource = items_.get_allocator().resource();
+        const auto inserted = items_.emplace(it, String(key, resource), Node(std::move(value), resource));
+        return { inserted, true };
+    }
+
+    std::pmr::polymorphic_allocator<Dict::value_type> Dict::get_allocator() const {
+        return items_.get_allocator();
+    }
+
+    bool Dict::operator==(const Dict& other) const {
+        return items_ == other.items_;
+    }
+
+    bool Dict::operator!=(const Dict& other) const {
+        return !(*this == other);
+    }
+
+    // ----------------- Document -----------------
+
     Document::Document(Node root)
         : root_(std::move(root)) {
     }
@@ -528,12 +1326,386 @@ namespace json {
         return root_ != other.root_;
     }
 
-    Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+    LazyDocument::LazyDocument(std::string_view text, std::vector<Token> tape)
+        : text_(text)
+        , tape_(std::move(tape)) {
+    }
+
+    LazyNode LazyDocument::GetRoot() const {
+        return LazyNode(tape_.data(), text_.data());
+    }
+
+    LazyNode::LazyNode(const Token* token, const char* text)
+        : token_(token)
+        , text_(text) {
+    }
+
+    bool LazyNode::IsNull() const {
+        return token_->type == Token::Type::NONE;
+    }
+
+    bool LazyNode::IsInt() const {
+        if (!IsDouble() || !IsIntegerToken(Text())) {
+            return false;
+        }
+        int value = 0;
+        const auto text = Text();
+        return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc{};
+    }
+
+    bool LazyNode::IsDouble() const {
+        return token_->type == Token::Type::NUMBER;
+    }
+
+    bool LazyNode::IsPureDouble() const {
+        if (!IsDouble()) {
+            return false;
+        }
+        // Целые числа, не помещающиеся в int64_t, хранятся как double
+        std::int64_t value = 0;
+        const auto text = Text();
+        return !IsIntegerToken(text) || std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{};
+    }
+
+    bool LazyNode::IsBool() const {
+        return token_->type == Token::Type::BOOL;
+    }
+
+    bool LazyNode::IsString() const {
+        return token_->type == Token::Type::STRING;
+    }
+
+    bool LazyNode::IsArray() const {
+        return token_->type == Token::Type::ARRAY;
+    }
+
+    bool LazyNode::IsMap() const {
+        return token_->type == Token::Type::DICT;
+    }
+
+    int LazyNode::AsInt() const {
+        if (!IsInt()) {
+            throw TypeMismatchException();
+        }
+        int value = 0;
+        const auto text = Text();
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
+    double LazyNode::AsDouble() const {
+        Expect(Token::Type::NUMBER);
+        double value = 0.0;
+        const auto text = Text();
+        if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) {
+            throw ParsingError("Failed to convert "s + std::string(text) + " to number"s);
+        }
+        return value;
+    }
+
+    bool LazyNode::AsBool() const {
+        Expect(Token::Type::BOOL);
+        return text_[token_->Begin()] == 't';
+    }
+
+    std::string LazyNode::AsString() const {
+        std::string buffer;
+        const auto value = AsStringView(buffer);
+        return token_->escaped ? buffer : std::string(value);
+    }
+
+    std::string_view LazyNode::AsStringView(std::string& buffer) const {
+        Expect(Token::Type::STRING);
+        const auto text = Text();
+        const auto content = text.substr(1, text.size() - 2);
+        if (!token_->escaped) {
+            return content;
+        }
+
+        // Синтаксис строки проверен при разборе документа
+        buffer.clear();
+        buffer.reserve(content.size());
+        for (size_t i = 0; i < content.size(); ++i) {
+            buffer.push_back(content[i] == '\\' ? Unescape(content[++i]) : content[i]);
+        }
+        return buffer;
+    }
+
+    size_t LazyNode::Size() const {
+        if (!IsArray() && !IsMap()) {
+            throw TypeMismatchException();
+        }
+        return token_->size;
+    }
+
+    LazyNode::Iterator LazyNode::begin() const {
+        Expect(Token::Type::ARRAY);
+        return Iterator(token_ + 1, text_);
+    }
+
+    LazyNode::Iterator LazyNode::end() const {
+        Expect(Token::Type::ARRAY);
+        return Iterator(token_ + token_->span, text_);
+    }
+
+    LazyNode LazyNode::operator[](size_t index) const {
+        if (index >= Size() || !IsArray()) {
+            throw std::out_of_range("Index out of range"s);
+        }
+        auto it = begin();
+        std::advance(it, index);
+        return *it;
+    }
+
+    bool LazyNode::Contains(std::string_view key) const {
+        return FindValue(key) != nullptr;
+    }
+
+    LazyNode LazyNode::At(std::string_view key) const {
+        const Token* value = FindValue(key);
+        if (value == nullptr) {
+            throw std::out_of_range("Key not found"s);
+        }
+        return LazyNode(value, text_);
+    }
+
+    std::string_view LazyNode::Text() const {
+        return std::string_view(text_ + token_->Begin(), token_->End() - token_->Begin());
+    }
+
+    const LazyNode::Token* LazyNode::FindValue(std::string_view key) const {
+        Expect(Token::Type::DICT);
+        // Как и в Dict, из элементов с одинаковым ключом учитывается первый
+        const Token* const end = token_ + token_->span;
+        for (const Token* item = token_ + 1; item != end;) {
+            const LazyNode item_key(item, text_);
+            const Token* const value = item + 1;
+            const bool found = item->escaped
+                ? item_key.AsString() == key
+                : item_key.Text().substr(1, item->End() - item->Begin() - 2) == key;
+            if (found) {
+                return value;
+            }
+            item = value + value->span;
+        }
+        return nullptr;
+    }
+
+    std::logic_error LazyNode::TypeMismatchException() {
+        return std::logic_error("Type mismatch"s);
+    }
+
+    const LazyNode::Token& LazyNode::Expect(Token::Type type) const {
+        if (token_->type != type) {
+            throw TypeMismatchException();
+        }
+        return *token_;
+    }
+
+    LazyNode::Iterator::Iterator(const Token* token, const char* text)
+        : token_(token)
+        , text_(text) {
+    }
+
+    LazyNode LazyNode::Iterator::operator*() const {
+        return LazyNode(token_, text_);
+    }
+
+    LazyNode::Iterator& LazyNode::Iterator::operator++() {
+        token_ += token_->span;
+        return *this;
+    }
+
+    bool LazyNode::Iterator::operator==(const Iterator& other) const {
+        return token_ == other.token_;
+    }
+
+    bool LazyNode::Iterator::operator!=(const Iterator& other) const {
+        return token_ != other.token_;
+    }
+
+    void Parse(std::string_view input, Handler& handler) {
+        Parser<Handler> parser(input, handler);
+        parser.ParseValue();
+    }
+
+    Document Load(std::string_view input, std::pmr::memory_resource* resource) {
+        TreeBuilder builder(resource);
+        Parser<TreeBuilder> parser(input, builder);
+        parser.ParseValue();
+        return Document{ builder.ExtractRoot() };
+    }
+
+    Document Load(std::istream& input, std::pmr::memory_resource* resource) {
+        const std::string buffer{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+        return Load(std::string_view(buffer), resource);
+    }
+
+    LazyDocument LoadLazy(std::string_view input) {
+        if (input.size() >> 48 != 0) {
+            throw ParsingError("Document is too large"s);
+        }
+        TapeBuilder builder(input);
+        Parser<TapeBuilder> parser(input, builder);
+        parser.ParseValue();
+        return LazyDocument(input, builder.ExtractTape());
+    }
+
+    Writer::Writer(std::ostream& output, PrintOptions options)
+        : output_(output)
+        , options_(options) {
+    }
+
+    Writer& Writer::StartArray() {
+        StartContainer('[', false);
+        return *this;
+    }
+
+    Writer& Writer::EndArray() {
+        EndContainer(']', false);
+        return *this;
+    }
+
+    Writer& Writer::StartDict() {
+        StartContainer('{', true);
+        return *this;
+    }
+
+    Writer& Writer::Key(std::string_view key) {
+        if (containers_.empty() || !containers_.back().is_dict || has_key_) {
+            throw std::logic_error("Key outside of dict"s);
+        }
+        BeginItem();
+        PrintString(key, output_);
+        output_ << (options_.compact ? ":"sv : ": "sv);
+        has_key_ = true;
+        return *this;
+    }
+
+    Writer& Writer::EndDict() {
+        EndContainer('}', true);
+        return *this;
+    }
+
+    Writer& Writer::Value(std::nullptr_t) {
+        BeginValue();
+        output_ << "null"sv;
+        return *this;
+    }
+
+    Writer& Writer::Value(bool value) {
+        BeginValue();
+        output_ << (value ? "true"sv : "false"sv);
+        return *this;
+    }
+
+    Writer& Writer::Value(std::int64_t value) {
+        BeginValue();
+        util::WriteNumber(output_, value);
+        return *this;
+    }
+
+    Writer& Writer::Value(double value) {
+        BeginValue();
+        util::WriteNumber(output_, value, options_.double_format);
+        return *this;
+    }
+
+    Writer& Writer::Value(std::string_view value) {
+        BeginValue();
+        PrintString(value, output_);
+        return *this;
+    }
+
+    Writer& Writer::Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::StringValue(const std::function<void(std::ostream&)>& write) {
+        BeginValue();
+        output_.put('\"');
+        {
+            EscapingBuffer buffer(output_);
+            std::ostream stream(&buffer);
+            write(stream);
+            stream.flush();
+        }
+        output_.put('\"');
+        return *this;
+    }
+
+    Writer& Writer::Items(std::string_view items, size_t count) {
+        if (containers_.empty() || containers_.back().is_dict) {
+            throw std::logic_error("Items outside of array"s);
+        }
+        output_ << items;
+        containers_.back().size += count;
+        return *this;
+    }
+
+    Writer Writer::ArrayItems(std::ostream& output, PrintOptions options, size_t index) {
+        Writer writer(output, options);
+        writer.containers_.push_back({ false, index });
+        return writer;
+    }
+
+    void Writer::BeginValue() {
+        if (containers_.empty()) {
+            return;
+        }
+        if (containers_.back().is_dict) {
+            if (!has_key_) {
+                throw std::logic_error("Value without key"s);
+            }
+            has_key_ = false;
+            return;
+        }
+        BeginItem();
+    }
+
+    void Writer::BeginItem() {
+        if (containers_.back().size++ > 0) {
+            output_ << ',';
+            if (!options_.compact) {
+                output_ << '\n';
+            }
+        }
+        Indent();
+    }
+
+    void Writer::StartContainer(char bracket, bool is_dict) {
+        BeginValue();
+        output_ << bracket;
+        if (!options_.compact) {
+            output_ << '\n';
+        }
+        containers_.push_back({ is_dict, 0 });
+    }
+
+    void Writer::EndContainer(char bracket, bool is_dict) {
+        if (containers_.empty() || containers_.back().is_dict != is_dict || has_key_) {
+            throw std::logic_error("Unexpected end of container"s);
+        }
+        if (containers_.back().size > 0 && !options_.compact) {
+            output_ << '\n';
+        }
+        containers_.pop_back();
+        Indent();
+        output_ << bracket;
+    }
+
+    void Writer::Indent() {
+        if (options_.compact) {
+            return;
+        }
+        for (size_t i = 0; i < containers_.size(); ++i) {
+            output_ << "    "sv;
+        }
     }
 
-    void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), output, 0);
+    void Print(const Document& doc, std::ostream& output, PrintOptions options) {
+        Writer writer(output, options);
+        PrintNode(doc.GetRoot(), writer);
     }
 
 }  // namespace json
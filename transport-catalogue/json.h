@@ -1,39 +1,109 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <iterator>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "number_format.h"
+
 namespace json {
 
+    /*
+     * Строки и контейнеры дерева Node размещаются в ресурсе памяти std::pmr::memory_resource,
+     * поэтому всё дерево можно разместить, например, в std::pmr::monotonic_buffer_resource.
+     * Копия узла, созданная обычным конструктором копирования, использует ресурс по умолчанию
+     */
     class Node;
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+    class Dict;
+    using Array = std::pmr::vector<Node>;
 
     class ParsingError : public std::runtime_error {
     public:
         using runtime_error::runtime_error;
     };
 
+    /*
+     * Неизменяемая строка с оптимизацией для коротких значений: строки длиной до 15 байт
+     * хранятся внутри объекта. Длинная строка размещается в ресурсе памяти вместе с указателем
+     * на этот ресурс, поэтому сам объект занимает 16 байт
+     */
+    class String {
+    public:
+        String() noexcept;
+        String(std::string_view value, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        String(const String& other);
+        String(const String& other, std::pmr::memory_resource* resource);
+        String(String&& other) noexcept;
+        String(String&& other, std::pmr::memory_resource* resource);
+        ~String();
+
+        String& operator=(const String& other);
+        String& operator=(String&& other) noexcept;
+
+        const char* data() const noexcept;
+        size_t size() const noexcept;
+
+        operator std::string_view() const noexcept {
+            return { data(), size() };
+        }
+
+    private:
+        static constexpr size_t SHORT_CAPACITY = 15;
+        static constexpr unsigned char LONG_MARKER = 0xFF;
+
+        // Короткая строка: символы в bytes_[0, 15), длина в bytes_[15].
+        // Длинная строка: указатель на блок в bytes_[0, 8), длина в bytes_[8, 12), bytes_[15] == LONG_MARKER.
+        // Блок начинается с указателя на ресурс, из которого он выделен, за ним следуют символы
+        alignas(void*) char bytes_[16];
+
+        bool IsLong() const noexcept;
+        char* LongBlock() const noexcept;
+        std::pmr::memory_resource* LongResource() const noexcept;
+        void Assign(std::string_view value, std::pmr::memory_resource* resource);
+        void Release() noexcept;
+    };
+
+    bool operator==(const String& lhs, const String& rhs);
+    bool operator!=(const String& lhs, const String& rhs);
+    bool operator<(const String& lhs, const String& rhs);
+
+    /*
+     * Узел занимает 24 байта: короткие строки и числа хранятся в нём непосредственно,
+     * массивы и словари - в отдельном блоке, выделенном из ресурса памяти контейнера
+     */
     class Node {
     public:
-        using Value = std::variant<nullptr_t, int, double, std::string, bool, Array, Dict>;
-
-        Node() = default;
-        Node(nullptr_t);
-        Node(int value);
-        Node(double value);
-        Node(std::string value);
-        Node(bool value);
+        Node() noexcept;
+        Node(const Node& other);
+        Node(Node&& other) noexcept;
+        // Копирует (перемещает) значение other, размещая строки и контейнеры в resource
+        Node(const Node& other, std::pmr::memory_resource* resource);
+        Node(Node&& other, std::pmr::memory_resource* resource);
+        Node(nullptr_t) noexcept;
+        Node(int value) noexcept;
+        // Значения, помещающиеся в int, хранятся как int
+        Node(std::int64_t value) noexcept;
+        Node(double value) noexcept;
+        Node(std::string_view value, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        Node(const std::string& value);
+        Node(String value) noexcept;
+        Node(bool value) noexcept;
         Node(Array array);
         Node(Dict map);
-        Node(Value value);
+        ~Node();
 
         bool IsNull() const;
         bool IsInt() const;
+        bool IsInt64() const;
         bool IsDouble() const;
         bool IsPureDouble() const;
         bool IsBool() const;
@@ -42,21 +112,93 @@ namespace json {
         bool IsMap() const;
 
         int AsInt() const;
+        std::int64_t AsInt64() const;
         bool AsBool() const;
         double AsDouble() const;
-        const std::string& AsString() const;
+        std::string_view AsString() const;
         const Array& AsArray() const;
         const Dict& AsMap() const;
 
+        Node& operator=(const Node& other);
+        Node& operator=(Node&& other) noexcept;
+
         bool operator==(const Node& other) const;
         bool operator!=(const Node& other) const;
 
     private:
-        Value value_;
+        enum class Type : unsigned char {
+            NONE,
+            INT,
+            INT64,
+            DOUBLE,
+            STRING,
+            BOOL,
+            ARRAY,
+            DICT
+        };
+
+        union {
+            int int_;
+            std::int64_t int64_;
+            double double_;
+            bool bool_;
+            String string_;
+            Array* array_;
+            Dict* dict_;
+        };
+        Type type_;
+
+        void MoveFrom(Node& other) noexcept;
+        void Destroy() noexcept;
 
         static std::logic_error TypeMismatchException();
     };
 
+    /*
+     * Словарь хранится как вектор пар ключ-значение, упорядоченный по ключу.
+     * Поиск выполняется двоичным поиском и не требует создания временной строки
+     */
+    class Dict {
+    public:
+        using value_type = std::pair<String, Node>;
+        using Items = std::pmr::vector<value_type>;
+        using const_iterator = Items::const_iterator;
+
+        Dict() = default;
+        explicit Dict(std::pmr::memory_resource* resource);
+        // Элементы могут идти в любом порядке; из элементов с одинаковым ключом остаётся первый
+        explicit Dict(Items items);
+        Dict(std::initializer_list<std::pair<std::string_view, Node>> items);
+        Dict(const Dict& other) = default;
+        Dict(Dict&& other) = default;
+        // Копирует (перемещает) элементы other, размещая их в resource
+        Dict(const Dict& other, std::pmr::memory_resource* resource);
+        Dict(Dict&& other, std::pmr::memory_resource* resource);
+
+        Dict& operator=(const Dict& other) = default;
+        Dict& operator=(Dict&& other) = default;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+        size_t size() const;
+        bool empty() const;
+
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+        const Node& at(std::string_view key) const;
+
+        // Добавляет элемент, если ключа key ещё нет в словаре
+        std::pair<const_iterator, bool> emplace(std::string_view key, Node value);
+
+        std::pmr::polymorphic_allocator<value_type> get_allocator() const;
+
+        bool operator==(const Dict& other) const;
+        bool operator!=(const Dict& other) const;
+
+    private:
+        Items items_;
+    };
+
     class Document {
     public:
         explicit Document(Node root);
@@ -70,8 +212,262 @@ namespace json {
         Node root_;
     };
 
-    Document Load(std::istream& input);
+    class LazyNode;
+
+    /*
+     * Документ, при разборе которого строится только плоская лента токенов: тип
+     * и положение каждого значения и ключа в тексте. Строки и числа не преобразуются,
+     * контейнеры не создаются. Документ ссылается на текст, который должен его пережить
+     */
+    class LazyDocument {
+    public:
+        struct Token {
+            enum class Type : unsigned char {
+                NONE,
+                BOOL,
+                NUMBER,
+                STRING,
+                ARRAY,
+                DICT
+            };
+
+            Type type = Type::NONE;
+            // Строка содержит escape-последовательности
+            bool escaped = false;
+            // Границы текста токена; у строк - вместе с кавычками, у контейнеров - со скобками.
+            // Хранятся в 48 битах, разделённых на старшую и младшую части, чтобы токен занимал 24 байта
+            uint16_t begin_high = 0;
+            uint16_t end_high = 0;
+            uint32_t begin_low = 0;
+            uint32_t end_low = 0;
+            // Число токенов значения вместе с вложенными
+            uint32_t span = 1;
+            // Число элементов массива или словаря
+            uint32_t size = 0;
+
+            uint64_t Begin() const {
+                return uint64_t{ begin_high } << 32 | begin_low;
+            }
+
+            uint64_t End() const {
+                return uint64_t{ end_high } << 32 | end_low;
+            }
+
+            void SetBegin(uint64_t pos) {
+                begin_high = static_cast<uint16_t>(pos >> 32);
+                begin_low = static_cast<uint32_t>(pos);
+            }
+
+            void SetEnd(uint64_t pos) {
+                end_high = static_cast<uint16_t>(pos >> 32);
+                end_low = static_cast<uint32_t>(pos);
+            }
+        };
+
+        LazyDocument(std::string_view text, std::vector<Token> tape);
+
+        LazyNode GetRoot() const;
+
+    private:
+        std::string_view text_;
+        std::vector<Token> tape_;
+    };
+
+    /*
+     * Значение документа LazyDocument. Хранит только ссылку на токен документа: строки
+     * и числа преобразуются из текста при каждом обращении к ним, поиск в словаре и массиве
+     * выполняется перебором. Действительно, пока существуют документ и его текст
+     */
+    class LazyNode {
+    public:
+        class Iterator;
+
+        bool IsNull() const;
+        bool IsInt() const;
+        bool IsDouble() const;
+        bool IsPureDouble() const;
+        bool IsBool() const;
+        bool IsString() const;
+        bool IsArray() const;
+        bool IsMap() const;
+
+        int AsInt() const;
+        double AsDouble() const;
+        bool AsBool() const;
+        std::string AsString() const;
+        // Возвращает строку без копирования; строка с escape-последовательностями
+        // преобразуется в buffer, и результат действителен, пока buffer не изменён
+        std::string_view AsStringView(std::string& buffer) const;
+
+        // Число элементов массива или словаря
+        size_t Size() const;
+
+        // Элементы массива
+        Iterator begin() const;
+        Iterator end() const;
+        LazyNode operator[](size_t index) const;
+
+        // Значения словаря по ключу
+        bool Contains(std::string_view key) const;
+        LazyNode At(std::string_view key) const;
+        // Вызывает callback(std::string_view key, LazyNode value) для каждого элемента словаря
+        // в порядке следования в документе, включая элементы с повторяющимися ключами.
+        // Ключ действителен только до возврата из callback
+        template <typename Callback>
+        void ForEachItem(Callback callback) const;
+
+        // Исходный текст значения
+        std::string_view Text() const;
+
+    private:
+        friend class LazyDocument;
+
+        using Token = LazyDocument::Token;
+
+        const Token* token_;
+        const char* text_;
+
+        LazyNode(const Token* token, const char* text);
+
+        // Значение словаря с ключом key или nullptr
+        const Token* FindValue(std::string_view key) const;
+        const Token& Expect(Token::Type type) const;
+        static std::logic_error TypeMismatchException();
+    };
+
+    class LazyNode::Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = LazyNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const LazyNode*;
+        using reference = LazyNode;
+
+        LazyNode operator*() const;
+        Iterator& operator++();
+
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        friend class LazyNode;
+
+        const Token* token_;
+        const char* text_;
+
+        Iterator(const Token* token, const char* text);
+    };
+
+    template <typename Callback>
+    void LazyNode::ForEachItem(Callback callback) const {
+        const Token* const end = token_ + Expect(Token::Type::DICT).span;
+        std::string buffer;
+        for (const Token* item = token_ + 1; item != end;) {
+            const Token* const value = item + 1;
+            callback(LazyNode(item, text_).AsStringView(buffer), LazyNode(value, text_));
+            item = value + value->span;
+        }
+    }
+
+    /*
+     * Интерфейс обработчика событий, которые генерирует Parse по мере чтения документа.
+     * Строки передаются в виде string_view, действительных только до возврата из обработчика
+     */
+    class Handler {
+    public:
+        virtual void Null() = 0;
+        virtual void Bool(bool value) = 0;
+        virtual void Int(std::int64_t value) = 0;
+        virtual void Double(double value) = 0;
+        virtual void String(std::string_view value) = 0;
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void StartDict() = 0;
+        virtual void Key(std::string_view key) = 0;
+        virtual void EndDict() = 0;
+
+    protected:
+        ~Handler() = default;
+    };
+
+    // Разбирает документ без построения дерева Node, передавая его элементы обработчику
+    void Parse(std::string_view input, Handler& handler);
+
+    // Строки и контейнеры документа размещаются в resource, который должен пережить документ
+    Document Load(std::string_view input, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    // Считывает поток целиком в буфер и разбирает его
+    Document Load(std::istream& input, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Разбирает документ, проверяя его синтаксис, но не преобразуя строки и числа.
+    // Текст должен пережить документ; его размер не может превышать 2^48 байт,
+    // а число значений и ключей в нём - 2^32 - 1
+    LazyDocument LoadLazy(std::string_view input);
+
+    struct PrintOptions {
+        // Документ выводится без отступов и переводов строк
+        bool compact = false;
+        util::DoubleFormat double_format = util::DoubleFormat::GENERAL;
+    };
+
+    /*
+     * Записывает документ в поток по мере вызова методов, не строя дерево Node.
+     * Формат совпадает с Print; ключи словаря выводятся в порядке вызовов Key,
+     * поэтому для совпадения с Print их нужно передавать по возрастанию.
+     * При нарушении структуры документа выбрасывается std::logic_error
+     */
+    class Writer {
+    public:
+        explicit Writer(std::ostream& output, PrintOptions options = {});
+
+        Writer& StartArray();
+        Writer& EndArray();
+        Writer& StartDict();
+        Writer& Key(std::string_view key);
+        Writer& EndDict();
+
+        Writer& Value(std::nullptr_t);
+        Writer& Value(bool value);
+        Writer& Value(std::int64_t value);
+        Writer& Value(double value);
+        Writer& Value(std::string_view value);
+        Writer& Value(const char* value);
+        // Выводит строку, которую функция write записывает в переданный ей поток.
+        // Символы экранируются по мере записи, сама строка целиком в памяти не хранится
+        Writer& StringValue(const std::function<void(std::ostream&)>& write);
+
+        // Выводит готовый текст count элементов текущего массива, записанный экземпляром,
+        // который создан ArrayItems с числом предшествующих элементов, равным размеру массива
+        Writer& Items(std::string_view items, size_t count);
+
+        // Создаёт экземпляр для вывода элементов корневого массива, начиная с элемента с номером index.
+        // Скобки массива выводит основной экземпляр, поэтому части массива можно выводить независимо
+        static Writer ArrayItems(std::ostream& output, PrintOptions options, size_t index);
+
+        template <typename Integer, std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool>, bool> = true>
+        Writer& Value(Integer value) {
+            return Value(static_cast<std::int64_t>(value));
+        }
+
+    private:
+        struct Container {
+            bool is_dict = false;
+            size_t size = 0;
+        };
+
+        std::ostream& output_;
+        PrintOptions options_;
+        std::vector<Container> containers_;
+        bool has_key_ = false;
+
+        // Выводит разделитель и отступ перед значением
+        void BeginValue();
+        void BeginItem();
+        void StartContainer(char bracket, bool is_dict);
+        void EndContainer(char bracket, bool is_dict);
+        void Indent();
+    };
 
-    void Print(const Document& doc, std::ostream& output);
+    // Числа записываются без учёта локали и настроек потока
+    void Print(const Document& doc, std::ostream& output, PrintOptions options = {});
 
 }  // namespace json
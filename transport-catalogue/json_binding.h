@@ -0,0 +1,256 @@
+#pragma once
+
+#include "json.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+	/*
+	 * Совершенная хеш-функция набора из N различных ключей, построенная при компиляции:
+	 * каждому ключу набора соответствует своя ячейка таблицы, поэтому поиск ключа
+	 * сводится к вычислению хеша и одному сравнению строк
+	 */
+	template <size_t N>
+	class KeyTable {
+	public:
+		constexpr explicit KeyTable(const std::array<std::string_view, N>& keys)
+			: keys_(keys) {
+			for (uint32_t seed = 0; seed < MAX_SEED; ++seed) {
+				if (TryBuild(seed)) {
+					seed_ = seed;
+					return;
+				}
+			}
+			// Выброс исключения не является константным выражением:
+			// набор с повторяющимися ключами не скомпилируется
+			throw std::logic_error("Failed to build perfect hash");
+		}
+
+		// Номер ключа в наборе или N, если ключа в наборе нет
+		constexpr size_t Find(std::string_view key) const {
+			const size_t index = slots_[Slot(key, seed_)];
+			return index < N && keys_[index] == key ? index : N;
+		}
+
+	private:
+		static constexpr size_t CountSlots() {
+			size_t slots = 2;
+			while (slots < 2 * N) {
+				slots *= 2;
+			}
+			return slots;
+		}
+
+		// Не менее двух ячеек на ключ; число ячеек - степень двойки
+		static constexpr size_t SLOTS = CountSlots();
+		static constexpr uint32_t MAX_SEED = 1 << 16;
+
+		std::array<std::string_view, N> keys_;
+		std::array<size_t, SLOTS> slots_{};
+		uint32_t seed_ = 0;
+
+		// FNV-1a, начальное значение которой зависит от зерна
+		static constexpr size_t Slot(std::string_view key, uint32_t seed) {
+			uint32_t hash = 2166136261u ^ seed;
+			for (const char c : key) {
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 16777619u;
+			}
+			return (hash ^ (hash >> 16)) & (SLOTS - 1);
+		}
+
+		constexpr bool TryBuild(uint32_t seed) {
+			for (auto& slot : slots_) {
+				slot = N;
+			}
+			for (size_t i = 0; i < N; ++i) {
+				auto& slot = slots_[Slot(keys_[i], seed)];
+				if (slot != N) {
+					return false;
+				}
+				slot = i;
+			}
+			return true;
+		}
+	};
+
+	// Описание поля структуры Owner, которое хранится в словаре по ключу key
+	template <typename Owner, typename Value>
+	struct Field {
+		std::string_view key;
+		Value Owner::* member;
+		bool required = true;
+	};
+
+	template <typename Owner, typename Value>
+	constexpr Field<Owner, Value> RequiredField(std::string_view key, Value Owner::* member) {
+		return { key, member, true };
+	}
+
+	template <typename Owner, typename Value>
+	constexpr Field<Owner, Value> OptionalField(std::string_view key, Value Owner::* member) {
+		return { key, member, false };
+	}
+
+	/*
+	 * Специализация Layout<T> описывает представление структуры T в виде словаря:
+	 * статическое поле FIELDS - кортеж описаний полей, созданных RequiredField и OptionalField.
+	 * Специализация EnumLayout<E> описывает строковые значения перечисления E:
+	 * статическое поле VALUES - массив пар {строка, значение}
+	 */
+	template <typename T>
+	struct Layout;
+
+	template <typename E>
+	struct EnumLayout;
+
+	// Заполняет поля value, описанные в Layout<T>, за один проход по словарю node.
+	// Остальные ключи пропускаются, из повторяющихся ключей учитывается первый.
+	// Если в словаре нет обязательного ключа, выбрасывает std::out_of_range
+	template <typename T>
+	void BindLazy(const LazyNode& node, T& value);
+
+	template <typename T>
+	T BindLazy(const LazyNode& node) {
+		T value;
+		BindLazy(node, value);
+		return value;
+	}
+
+	// Преобразует значение документа в значение типа T. Для типов, которые не поддерживаются
+	// ниже и не описаны с помощью Layout или EnumLayout, ValueBinder специализируется отдельно
+	template <typename T, typename = void>
+	struct ValueBinder {
+		static void Bind(const LazyNode& node, T& value) {
+			BindLazy(node, value);
+		}
+	};
+
+	template <>
+	struct ValueBinder<bool> {
+		static void Bind(const LazyNode& node, bool& value) {
+			value = node.AsBool();
+		}
+	};
+
+	template <>
+	struct ValueBinder<int> {
+		static void Bind(const LazyNode& node, int& value) {
+			value = node.AsInt();
+		}
+	};
+
+	template <>
+	struct ValueBinder<double> {
+		static void Bind(const LazyNode& node, double& value) {
+			value = node.AsDouble();
+		}
+	};
+
+	template <>
+	struct ValueBinder<std::string> {
+		static void Bind(const LazyNode& node, std::string& value) {
+			value = node.AsString();
+		}
+	};
+
+	template <typename T>
+	struct ValueBinder<std::vector<T>> {
+		static void Bind(const LazyNode& node, std::vector<T>& values) {
+			values.clear();
+			values.reserve(node.Size());
+			for (const auto item : node) {
+				ValueBinder<T>::Bind(item, values.emplace_back());
+			}
+		}
+	};
+
+	namespace detail {
+
+		template <typename Values, size_t... I>
+		constexpr std::array<std::string_view, sizeof...(I)> EnumKeys(const Values& values, std::index_sequence<I...>) {
+			return { values[I].first... };
+		}
+
+		template <typename Fields, size_t... I>
+		constexpr std::array<std::string_view, sizeof...(I)> FieldKeys(const Fields& fields, std::index_sequence<I...>) {
+			return { std::get<I>(fields).key... };
+		}
+
+		template <typename Fields, size_t... I>
+		constexpr uint64_t RequiredMask(const Fields& fields, std::index_sequence<I...>) {
+			return ((std::get<I>(fields).required ? uint64_t{1} << I : 0) | ... | 0);
+		}
+
+		template <typename T>
+		struct StructBinder {
+			static constexpr size_t SIZE = std::tuple_size_v<std::decay_t<decltype(Layout<T>::FIELDS)>>;
+			static_assert(SIZE <= 64, "Fields are tracked in a 64-bit mask");
+
+			using Indices = std::make_index_sequence<SIZE>;
+
+			static constexpr KeyTable<SIZE> KEYS{ FieldKeys(Layout<T>::FIELDS, Indices{}) };
+			static constexpr uint64_t REQUIRED = RequiredMask(Layout<T>::FIELDS, Indices{});
+
+			// Цепочка сравнений с номерами полей, известными при компиляции
+			template <size_t... I>
+			static void BindField(size_t index, const LazyNode& node, T& value, std::index_sequence<I...>) {
+				(void)((index == I && (BindMember(node, value.*(std::get<I>(Layout<T>::FIELDS).member)), true)) || ...);
+			}
+
+			template <typename Value>
+			static void BindMember(const LazyNode& node, Value& member) {
+				ValueBinder<Value>::Bind(node, member);
+			}
+		};
+
+	}  // namespace detail
+
+	template <typename E>
+	struct ValueBinder<E, std::enable_if_t<std::is_enum_v<E>>> {
+		static void Bind(const LazyNode& node, E& value) {
+			std::string buffer;
+			const auto name = node.AsStringView(buffer);
+			const size_t index = KEYS.Find(name);
+			if (index == SIZE) {
+				throw std::out_of_range("Unknown value " + std::string(name));
+			}
+			value = EnumLayout<E>::VALUES[index].second;
+		}
+
+	private:
+		static constexpr size_t SIZE = std::size(EnumLayout<E>::VALUES);
+		static constexpr KeyTable<SIZE> KEYS{ detail::EnumKeys(EnumLayout<E>::VALUES, std::make_index_sequence<SIZE>{}) };
+	};
+
+	template <typename T>
+	void BindLazy(const LazyNode& node, T& value) {
+		using Binder = detail::StructBinder<T>;
+
+		uint64_t bound = 0;
+		node.ForEachItem([&](std::string_view key, LazyNode item) {
+			const size_t index = Binder::KEYS.Find(key);
+			if (index == Binder::SIZE || (bound >> index & 1) != 0) {
+				return;
+			}
+			bound |= uint64_t{1} << index;
+			Binder::BindField(index, item, value, typename Binder::Indices{});
+		});
+
+		if ((bound & Binder::REQUIRED) != Binder::REQUIRED) {
+			throw std::out_of_range("Key not found");
+		}
+	}
+
+}  // namespace json
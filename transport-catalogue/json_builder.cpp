@@ -20,7 +20,7 @@ namespace json {
 		return builder_.EndArray();
 	}
 
-	BuilderArray BuilderArray::Value(Node::Value value) {
+	BuilderArray BuilderArray::Value(Node value) {
 		builder_.Value(std::move(value));
 		return BuilderArray(builder_);
 	}
@@ -39,7 +39,7 @@ namespace json {
 		return builder_.EndDict();
 	}
 
-	BuilderDict BuilderKey::Value(Node::Value value) {
+	BuilderDict BuilderKey::Value(Node value) {
 		builder_.Value(std::move(value));
 		return BuilderDict(builder_);
 	}
@@ -56,25 +56,34 @@ namespace json {
 
 	// ----------------- Builder -----------------
 
+	Builder::Frame::Frame(bool is_dict, std::pmr::memory_resource* resource)
+		: is_dict(is_dict)
+		, array(resource)
+		, items(resource) {
+	}
+
+	Builder::Builder(std::pmr::memory_resource* resource)
+		: resource_(resource) {
+	}
+
 	BuilderKey Builder::Key(std::string key) {
-		if (context_.empty() || context_.back().type != ContextType::DICT) {
+		if (frames_.empty() || !frames_.back().is_dict || frames_.back().has_key) {
 			throw std::logic_error("Key error");
 		}
 
-		values_.emplace_back(std::move(key));
-		context_.push_back({ ContextType::KEY, values_.size() - 1 });
+		auto& frame = frames_.back();
+		frame.key = String(key, resource_);
+		frame.has_key = true;
 
 		return BuilderKey(*this);
 	}
 
-	Builder& Builder::Value(Node::Value value) {
+	Builder& Builder::Value(Node value) {
 		if (!CanValue()) {
 			throw std::logic_error("Value error");
 		}
 
-		values_.emplace_back(std::move(value));
-
-		ExtractKeyIfNeeded();
+		AddValue(Node(std::move(value), resource_));
 
 		return *this;
 	}
@@ -83,24 +92,19 @@ namespace json {
 		if (!CanValue()) {
 			throw std::logic_error("StartDict error");
 		}
-		context_.push_back({ ContextType::DICT, values_.size() });
+		frames_.emplace_back(true, resource_);
 
 		return BuilderDict(*this);
 	}
 
 	Builder& Builder::EndDict() {
-		if (context_.empty() || context_.back().type != ContextType::DICT) {
+		if (frames_.empty() || !frames_.back().is_dict || frames_.back().has_key) {
 			throw std::logic_error("EndDict error");
 		}
 
-		Dict dict;
-		size_t index = context_.back().index;
-		for (; index < values_.size(); ++index) {
-			std::string key = values_[index++].AsString();
-			Node value = std::move(values_[index]);
-			dict.emplace(std::move(key), std::move(value));
-		}
-		ReplaceValue(std::move(dict));
+		Dict dict(std::move(frames_.back().items));
+		frames_.pop_back();
+		AddValue(std::move(dict));
 
 		return *this;
 	}
@@ -109,50 +113,61 @@ namespace json {
 		if (!CanValue()) {
 			throw std::logic_error("StartArray error");
 		}
-		context_.push_back({ ContextType::ARRAY, values_.size() });
+		frames_.emplace_back(false, resource_);
 		return BuilderArray(*this);
 	}
 
 	Builder& Builder::EndArray() {
-		if (context_.empty() || context_.back().type != ContextType::ARRAY) {
+		if (frames_.empty() || frames_.back().is_dict) {
 			throw std::logic_error("EndArray error");
 		}
 
-		Array arr;
-		size_t index = context_.back().index;
-		for (; index < values_.size(); ++index) {
-			arr.push_back(std::move(values_[index]));
-		}
-		ReplaceValue(std::move(arr));
+		Array array(std::move(frames_.back().array));
+		frames_.pop_back();
+		AddValue(std::move(array));
 
 		return *this;
 	}
 
-	Node Builder::Build() const {
-		if (!context_.empty() || values_.empty()) {
-			throw std::logic_error("Build error");
-		}
-		return values_.back();
+	Node Builder::Build() const& {
+		CheckBuilt();
+		return Node(root_, resource_);
+	}
+
+	Node Builder::Build() && {
+		CheckBuilt();
+		has_root_ = false;
+		return std::move(root_);
 	}
 
 	// ----------------- Helper functions -----------------
 
 	bool Builder::CanValue() const {
-		return (context_.empty() && values_.empty())
-			|| (!context_.empty() && context_.back().type != ContextType::DICT);
+		return (frames_.empty() && !has_root_)
+			|| (!frames_.empty() && (!frames_.back().is_dict || frames_.back().has_key));
 	}
 
-	void Builder::ExtractKeyIfNeeded() {
-		if (!context_.empty() && context_.back().type == ContextType::KEY) {
-			context_.pop_back();
+	void Builder::AddValue(Node value) {
+		if (frames_.empty()) {
+			root_ = std::move(value);
+			has_root_ = true;
+			return;
+		}
+
+		auto& frame = frames_.back();
+		if (frame.is_dict) {
+			frame.items.emplace_back(std::move(frame.key), std::move(value));
+			frame.has_key = false;
+		}
+		else {
+			frame.array.push_back(std::move(value));
 		}
 	}
 
-	void Builder::ReplaceValue(Node value) {
-		values_.resize(context_.back().index);
-		values_.push_back(std::move(value));
-		context_.pop_back();
-		ExtractKeyIfNeeded();
+	void Builder::CheckBuilt() const {
+		if (!frames_.empty() || !has_root_) {
+			throw std::logic_error("Build error");
+		}
 	}
 
 } // namespace json
\ No newline at end of file
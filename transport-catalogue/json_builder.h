@@ -2,6 +2,7 @@
 
 #include "json.h"
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -25,7 +26,7 @@ namespace json {
 		using BuilderItem::BuilderItem;
 		BuilderArray StartArray();
 		Builder& EndArray();
-		BuilderArray Value(Node::Value value);
+		BuilderArray Value(Node value);
 		BuilderDict StartDict();
 	};
 
@@ -39,37 +40,49 @@ namespace json {
 	class BuilderKey : public BuilderItem {
 	public:
 		using BuilderItem::BuilderItem;
-		BuilderDict Value(Node::Value value);
+		BuilderDict Value(Node value);
 		BuilderDict StartDict();
 		BuilderArray StartArray();
 	};
 
 	class Builder {
 	public:
+		// Строки и контейнеры построенного дерева размещаются в resource
+		explicit Builder(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
 		BuilderKey Key(std::string key);
-		Builder& Value(Node::Value value);
+		Builder& Value(Node value);
 		BuilderDict StartDict();
 		Builder& EndDict();
 		BuilderArray StartArray();
 		Builder& EndArray();
-		Node Build() const;
+		// Возвращает копию построенного дерева
+		Node Build() const&;
+		// Возвращает построенное дерево без копирования; после вызова построитель пуст
+		Node Build() &&;
 
 	private:
-		enum class ContextType {
-			ARRAY, DICT, KEY
-		};
+		// Незавершённый контейнер. Значения добавляются сразу в контейнер,
+		// который при его завершении становится значением Node без копирования элементов
+		struct Frame {
+			Frame(bool is_dict, std::pmr::memory_resource* resource);
 
-		struct Context {
-			ContextType type;
-			size_t index;
+			bool is_dict;
+			Array array;
+			Dict::Items items;
+			// Ключ, для которого ещё не добавлено значение
+			String key;
+			bool has_key = false;
 		};
 
-		std::vector<Context> context_;
-		std::vector<Node> values_;
+		std::pmr::memory_resource* resource_;
+		std::vector<Frame> frames_;
+		Node root_;
+		bool has_root_ = false;
 
 		bool CanValue() const;
-		void ExtractKeyIfNeeded();
-		void ReplaceValue(Node value);
+		void AddValue(Node value);
+		void CheckBuilt() const;
 	};
 
 } // namespace json
\ No newline at end of file
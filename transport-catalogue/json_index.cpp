@@ -0,0 +1,299 @@
+#include "json_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JSON_INDEX_X86_64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define JSON_INDEX_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define JSON_INDEX_TARGET_AVX2
+#endif
+
+namespace json {
+
+    namespace {
+
+        constexpr size_t BLOCK_SIZE = 64;
+        // Размер участка документа, индексируемого за один вызов Next
+        constexpr size_t WINDOW_SIZE = 64 * 1024;
+
+        // Для нулевого аргумента возвращает 64
+        int CountTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+            unsigned long index = 64;
+            _BitScanForward64(&index, value);
+            return static_cast<int>(index);
+#else
+            return value != 0 ? __builtin_ctzll(value) : 64;
+#endif
+        }
+
+        int CountOnes(uint64_t value) {
+#if defined(_MSC_VER)
+            return static_cast<int>(__popcnt64(value));
+#else
+            return __builtin_popcountll(value);
+#endif
+        }
+
+        // i-й бит результата равен чётности числа единичных битов value с 0-го по i-й
+        uint64_t PrefixXor(uint64_t value) {
+            value ^= value << 1;
+            value ^= value << 2;
+            value ^= value << 4;
+            value ^= value << 8;
+            value ^= value << 16;
+            value ^= value << 32;
+            return value;
+        }
+
+#if defined(JSON_INDEX_X86_64)
+        uint64_t Mask16(__m128i bytes) {
+            return static_cast<uint16_t>(_mm_movemask_epi8(bytes));
+        }
+
+        JSON_INDEX_TARGET_AVX2
+        uint64_t Mask32(__m256i bytes) {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+        }
+
+        JSON_INDEX_TARGET_AVX2
+        __m256i Equal32(__m256i bytes, char c) {
+            return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c));
+        }
+
+        bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 0);
+            if (regs[0] < 7) {
+                return false;
+            }
+            __cpuid(regs, 1);
+            // ОС должна сохранять регистры AVX при переключении контекста
+            const bool os_avx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+            __cpuidex(regs, 7, 0);
+            return os_avx && (regs[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+    }  // namespace
+
+    StructuralIndexer::StructuralIndexer(std::string_view input, Impl impl)
+        : input_(input)
+        , positions_(new uint32_t[WINDOW_SIZE + BLOCK_SIZE]) {
+        switch (impl) {
+        case Impl::AVX2:
+            classify_ = &ClassifyAvx2;
+            break;
+        case Impl::SSE2:
+            classify_ = &ClassifySse2;
+            break;
+        default:
+            classify_ = &ClassifyScalar;
+        }
+    }
+
+    StructuralIndexer::Impl StructuralIndexer::BestImpl() {
+#if defined(JSON_INDEX_X86_64)
+        static const Impl impl = CpuSupportsAvx2() ? Impl::AVX2 : Impl::SSE2;
+        return impl;
+#else
+        return Impl::SCALAR;
+#endif
+    }
+
+    bool StructuralIndexer::Next() {
+        size_ = 0;
+        if (stopped_ || offset_ == input_.size()) {
+            return false;
+        }
+
+        // В неполном документе индексируются только полные блоки
+        const size_t input_end = complete_ ? input_.size() : input_.size() - (input_.size() - offset_) % BLOCK_SIZE;
+        if (offset_ == input_end) {
+            return false;
+        }
+
+        base_ = offset_;
+        const size_t window_end = std::min(input_end, base_ + WINDOW_SIZE);
+        while (offset_ + BLOCK_SIZE <= window_end && !stopped_) {
+            IndexBlock(classify_(input_.data() + offset_), offset_ - base_, BLOCK_SIZE);
+            offset_ += BLOCK_SIZE;
+        }
+
+        if (offset_ < window_end && !stopped_) {
+            // Последний неполный блок дополняется пробелами, которые не попадают в индекс
+            char block[BLOCK_SIZE];
+            const size_t size = window_end - offset_;
+            std::memset(block, ' ', BLOCK_SIZE);
+            std::memcpy(block, input_.data() + offset_, size);
+            IndexBlock(classify_(block), offset_ - base_, size);
+            offset_ = window_end;
+        }
+
+        return true;
+    }
+
+    void StructuralIndexer::Extend(std::string_view input, bool complete) {
+        input_ = input;
+        complete_ = complete;
+    }
+
+    void StructuralIndexer::IndexBlock(const BlockMasks& masks, size_t block_offset, size_t size) {
+        // Символы, перед которыми стоит неэкранированная обратная косая черта.
+        // Обратные косые черты встречаются редко, поэтому обрабатываются по одной
+        uint64_t escaped = escaped_carry_;
+        uint64_t backslash = masks.backslash & ~escaped;
+        escaped_carry_ = 0;
+        while (backslash != 0) {
+            const int i = CountTrailingZeros(backslash);
+            if (i == BLOCK_SIZE - 1) {
+                escaped_carry_ = 1;
+                break;
+            }
+            escaped |= uint64_t{2} << i;
+            backslash &= ~(uint64_t{3} << i);
+        }
+
+        // Открывающая кавычка и содержимое строки попадают в маску, закрывающая кавычка - нет
+        const uint64_t quote = masks.quote & ~escaped;
+        const uint64_t in_string = PrefixXor(quote) ^ in_string_carry_;
+        in_string_carry_ = in_string >> (BLOCK_SIZE - 1) != 0 ? ~uint64_t{0} : 0;
+
+        const uint64_t outside = ~in_string;
+        // Скалярное значение начинается после пробельного или структурного символа
+        const uint64_t separator = (masks.whitespace | masks.structural) & outside;
+        const uint64_t scalar = ~(masks.whitespace | masks.structural | masks.quote) & outside;
+
+        uint64_t positions = (masks.structural & outside)
+                             | quote
+                             | ((masks.backslash | masks.newline) & in_string)
+                             | (scalar & (separator << 1 | separator_carry_));
+        separator_carry_ = separator >> (BLOCK_SIZE - 1);
+
+        if (size < BLOCK_SIZE) {
+            positions &= (uint64_t{1} << size) - 1;
+        }
+
+        if (const uint64_t stray_backslash = masks.backslash & outside; stray_backslash != 0) {
+            positions &= (uint64_t{1} << CountTrailingZeros(stray_backslash)) - 1;
+            stopped_ = true;
+        }
+
+        // Позиции записываются группами по 8 без проверки числа оставшихся битов: лишние
+        // записи попадают в запас в конце буфера и затираются позициями следующего блока
+        const size_t count = CountOnes(positions);
+        uint32_t* out = positions_.get() + size_;
+        const uint32_t offset = static_cast<uint32_t>(block_offset);
+        for (size_t i = 0; i < count; i += 8) {
+            for (size_t j = 0; j < 8; ++j) {
+                out[i + j] = offset + CountTrailingZeros(positions);
+                positions &= positions - 1;
+            }
+        }
+        size_ += count;
+    }
+
+    StructuralIndexer::BlockMasks StructuralIndexer::ClassifyScalar(const char* block) {
+        BlockMasks masks;
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            const uint64_t bit = uint64_t{1} << i;
+            switch (block[i]) {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '\n':
+            case '\r':
+                masks.newline |= bit;
+                masks.whitespace |= bit;
+                break;
+            case ' ':
+            case '\t':
+                masks.whitespace |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.structural |= bit;
+                break;
+            default:
+                break;
+            }
+        }
+        return masks;
+    }
+
+#if defined(JSON_INDEX_X86_64)
+
+    StructuralIndexer::BlockMasks StructuralIndexer::ClassifySse2(const char* block) {
+        BlockMasks masks;
+        for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            const auto eq = [bytes](char c) {
+                return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c));
+            };
+            // '[' | 0x20 == '{', ']' | 0x20 == '}'
+            const __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+            const __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                                                  _mm_cmpeq_epi8(lower, _mm_set1_epi8('}')));
+            const __m128i newline = _mm_or_si128(eq('\n'), eq('\r'));
+
+            masks.quote |= Mask16(eq('"')) << i;
+            masks.backslash |= Mask16(eq('\\')) << i;
+            masks.newline |= Mask16(newline) << i;
+            masks.whitespace |= Mask16(_mm_or_si128(newline, _mm_or_si128(eq(' '), eq('\t')))) << i;
+            masks.structural |= Mask16(_mm_or_si128(brackets, _mm_or_si128(eq(':'), eq(',')))) << i;
+        }
+        return masks;
+    }
+
+    JSON_INDEX_TARGET_AVX2
+    StructuralIndexer::BlockMasks StructuralIndexer::ClassifyAvx2(const char* block) {
+        BlockMasks masks;
+        for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+            const __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+            const __m256i brackets = _mm256_or_si256(Equal32(lower, '{'), Equal32(lower, '}'));
+            const __m256i newline = _mm256_or_si256(Equal32(bytes, '\n'), Equal32(bytes, '\r'));
+
+            masks.quote |= Mask32(Equal32(bytes, '"')) << i;
+            masks.backslash |= Mask32(Equal32(bytes, '\\')) << i;
+            masks.newline |= Mask32(newline) << i;
+            masks.whitespace |= Mask32(_mm256_or_si256(newline, _mm256_or_si256(Equal32(bytes, ' '), Equal32(bytes, '\t')))) << i;
+            masks.structural |= Mask32(_mm256_or_si256(brackets, _mm256_or_si256(Equal32(bytes, ':'), Equal32(bytes, ',')))) << i;
+        }
+        return masks;
+    }
+
+#else
+
+    // Без векторных инструкций обе реализации совпадают со скалярной
+    StructuralIndexer::BlockMasks StructuralIndexer::ClassifySse2(const char* block) {
+        return ClassifyScalar(block);
+    }
+
+    StructuralIndexer::BlockMasks StructuralIndexer::ClassifyAvx2(const char* block) {
+        return ClassifyScalar(block);
+    }
+
+#endif
+
+}  // namespace json
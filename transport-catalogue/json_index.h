@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace json {
+
+    /*
+     * Строит структурный индекс JSON-документа: позиции символов {}[]:, вне строк, всех
+     * неэкранированных кавычек, начал скалярных значений (чисел, true, false, null),
+     * а также обратных косых черт и переводов строк внутри строк.
+     * Документ обрабатывается блоками по 64 байта с помощью SSE2 или AVX2 (выбирается при запуске
+     * программы) либо без векторных инструкций, а индекс выдаётся по частям, чтобы его размер
+     * не зависел от размера документа.
+     * Обратная косая черта вне строки (экранированный пробельный символ между токенами)
+     * завершает построение индекса: остаток документа нужно разбирать посимвольно.
+     * Индекс используется для поиска границ элементов base_requests без разбора документа
+     * (BaseRequestsScanner в json_reader.cpp); сам парсер документ посимвольно просматривает быстрее
+     */
+    class StructuralIndexer {
+    public:
+        enum class Impl {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        explicit StructuralIndexer(std::string_view input, Impl impl = BestImpl());
+
+        // Индексирует очередной участок документа. Возвращает false, если индекс построен полностью
+        // или, для неполного документа, проиндексированы все полные блоки
+        bool Next();
+
+        // Продолжает индексирование документа, к которому добавлены данные: input начинается
+        // с прежнего документа. Пока complete равно false, документ считается неполным
+        // и его последний неполный блок не индексируется
+        void Extend(std::string_view input, bool complete);
+
+        // Индексирование завершено досрочно из-за обратной косой черты вне строки
+        bool Stopped() const {
+            return stopped_;
+        }
+
+        // Позиции очередного участка отсчитываются от начала участка Base()
+        size_t Base() const {
+            return base_;
+        }
+
+        const uint32_t* begin() const {
+            return positions_.get();
+        }
+
+        const uint32_t* end() const {
+            return positions_.get() + size_;
+        }
+
+        // Наиболее быстрая реализация, поддерживаемая процессором
+        static Impl BestImpl();
+
+    private:
+        // Маски классов символов блока из 64 байт: i-й бит соответствует i-му символу
+        struct BlockMasks {
+            uint64_t quote = 0;
+            uint64_t backslash = 0;
+            uint64_t whitespace = 0;
+            uint64_t newline = 0;
+            uint64_t structural = 0;
+        };
+
+        using Classifier = BlockMasks (*)(const char* block);
+
+        static BlockMasks ClassifyScalar(const char* block);
+        static BlockMasks ClassifySse2(const char* block);
+        static BlockMasks ClassifyAvx2(const char* block);
+
+        std::string_view input_;
+        bool complete_ = true;
+        Classifier classify_;
+        size_t offset_ = 0;
+        bool stopped_ = false;
+
+        size_t base_ = 0;
+        std::unique_ptr<uint32_t[]> positions_;
+        size_t size_ = 0;
+
+        // Состояние, переносимое между блоками
+        uint64_t escaped_carry_ = 0;
+        uint64_t in_string_carry_ = 0;
+        uint64_t separator_carry_ = 1;
+
+        // Добавляет позиции блока; size - число символов документа в блоке
+        void IndexBlock(const BlockMasks& masks, size_t block_offset, size_t size);
+    };
+
+}  // namespace json
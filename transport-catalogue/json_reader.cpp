@@ -1,204 +1,923 @@
-#include <cassert>
+#include <algorithm>
+#include <array>
+#include <future>
+#include <limits>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <variant>
 
 #include "json_reader.h"
-#include "json_builder.h"
+#include "json_binding.h"
+#include "json_index.h"
+#include "read_ahead.h"
 
 using namespace std::literals;
 
+namespace json {
+
+	template <>
+	struct EnumLayout<io::StatRequest::Type> {
+		static constexpr std::array<std::pair<std::string_view, io::StatRequest::Type>, 3> VALUES = { {
+			{ "Bus"sv, io::StatRequest::Type::BUS },
+			{ "Stop"sv, io::StatRequest::Type::STOP },
+			{ "Map"sv, io::StatRequest::Type::MAP },
+		} };
+	};
+
+	template <>
+	struct Layout<io::StatRequest> {
+		static constexpr std::tuple FIELDS = {
+			RequiredField("id"sv, &io::StatRequest::id),
+			RequiredField("type"sv, &io::StatRequest::type),
+			// У запроса Map названия нет
+			OptionalField("name"sv, &io::StatRequest::name),
+		};
+	};
+
+	template <>
+	struct Layout<io::RenderSettings> {
+		static constexpr std::tuple FIELDS = {
+			RequiredField("width"sv, &io::RenderSettings::width),
+			RequiredField("height"sv, &io::RenderSettings::height),
+			RequiredField("padding"sv, &io::RenderSettings::padding),
+			RequiredField("line_width"sv, &io::RenderSettings::line_width),
+			RequiredField("stop_radius"sv, &io::RenderSettings::stop_radius),
+			RequiredField("bus_label_font_size"sv, &io::RenderSettings::bus_label_font_size),
+			RequiredField("bus_label_offset"sv, &io::RenderSettings::bus_label_offset),
+			RequiredField("stop_label_font_size"sv, &io::RenderSettings::stop_label_font_size),
+			RequiredField("stop_label_offset"sv, &io::RenderSettings::stop_label_offset),
+			RequiredField("underlayer_color"sv, &io::RenderSettings::underlayer_color),
+			RequiredField("underlayer_width"sv, &io::RenderSettings::underlayer_width),
+			RequiredField("color_palette"sv, &io::RenderSettings::color_palette),
+		};
+	};
+
+	// Раздел base_requests читается отдельно (см. BaseRequestsHandler) и здесь пропускается
+	template <>
+	struct Layout<io::Input> {
+		static constexpr std::tuple FIELDS = {
+			RequiredField("stat_requests"sv, &io::Input::stat_requests),
+			RequiredField("render_settings"sv, &io::Input::render_settings),
+		};
+	};
+
+	// Смещение задаётся массивом [dx, dy]
+	template <>
+	struct ValueBinder<svg::Point> {
+		static void Bind(const LazyNode& node, svg::Point& point) {
+			point = svg::Point(node[0].AsDouble(), node[1].AsDouble());
+		}
+	};
+
+	// Цвет задаётся строкой, массивом [r, g, b] или массивом [r, g, b, opacity]
+	template <>
+	struct ValueBinder<svg::Color> {
+		static void Bind(const LazyNode& node, svg::Color& color) {
+			if (node.IsString()) {
+				color = node.AsString();
+				return;
+			}
+			else if (node.IsArray()) {
+				if (node.Size() == 3) {
+					color = svg::Rgb(node[0].AsInt(), node[1].AsInt(), node[2].AsInt());
+					return;
+				}
+				else if (node.Size() == 4) {
+					color = svg::Rgba(node[0].AsInt(), node[1].AsInt(), node[2].AsInt(), node[3].AsDouble());
+					return;
+				}
+			}
+			throw ParsingError("Invalid color"s);
+		}
+	};
+
+} // namespace json
+
 namespace io {
 
 	// ---------------------- Input ----------------------
 
-	JsonReader::JsonReader(std::istream& input)
-		: input_(input) {
-	}
+	namespace {
 
-	Input JsonReader::Read() {
-		Input input;
+		// Добавляет запросы base_requests в транспортный справочник. Остановки добавляются сразу,
+		// а расстояния и маршруты откладываются до вызова Finish и добавляются в исходном порядке
+		// после всех остановок: от порядка добавления зависит, какой из маршрутов с одинаковыми
+		// названиями находит справочник, и порядок маршрутов на карте
+		class CatalogueLoader {
+		public:
+			explicit CatalogueLoader(tc::TransportCatalogue& transport_catalogue)
+				: transport_catalogue_(transport_catalogue) {
+			}
 
-		const auto document = json::Load(input_).GetRoot().AsMap();
-		
-		for (const auto& base_request_node : document.at("base_requests"s).AsArray()) {
-			const auto& base_request = base_request_node.AsMap();			
-			const auto& request_type = base_request.at("type"s).AsString();
-			if (request_type == "Bus"s) {
-				input.buses.push_back(ReadBaseRequestBus(base_request));
+			tc::StopId GetStopId(std::string_view name) {
+				return transport_catalogue_.GetStopId(name);
 			}
-			else if (request_type == "Stop"s) {
-				input.stops.push_back(ReadBaseRequestStop(base_request));
+
+			void AddStop(BaseRequestStop stop) {
+				transport_catalogue_.AddStop(stop.id, stop.coordinates);
+				for (const auto& [to, distance] : stop.distances) {
+					deferred_distances_.push_back({ stop.id, to, distance });
+				}
 			}
-			else {
-				assert(false);
+
+			void AddBus(BaseRequestBus bus) {
+				deferred_buses_.push_back(std::move(bus));
 			}
-		}
 
-		for (const auto& stat_request_node : document.at("stat_requests"s).AsArray()) {
-			const auto& stat_request = stat_request_node.AsMap();
-			input.stat_requests.push_back(ReadStatRequest(stat_request));
-		}
+			// Вызывается в конце массива base_requests
+			void Finish() {
+				for (const auto& [from, to, distance] : deferred_distances_) {
+					if (transport_catalogue_.HasStop(to)) {
+						transport_catalogue_.AddDistance(from, to, distance);
+					}
+				}
+				deferred_distances_ = {};
 
-		input.render_settings = ReadRenderSettings(document.at("render_settings"s).AsMap());
+				for (auto& bus : deferred_buses_) {
+					transport_catalogue_.AddBus(std::move(bus.name), bus.ring, bus.stops);
+				}
+				deferred_buses_ = {};
+			}
 
-		return input;
-	}
+		private:
+			struct Distance {
+				tc::StopId from = 0;
+				tc::StopId to = 0;
+				uint32_t distance = 0;
+			};
 
-	BaseRequestBus JsonReader::ReadBaseRequestBus(const json::Dict& base_request) {
-		BaseRequestBus bus;
+			tc::TransportCatalogue& transport_catalogue_;
+			std::vector<Distance> deferred_distances_;
+			std::vector<BaseRequestBus> deferred_buses_;
+		};
 
-		bus.name = base_request.at("name"s).AsString();
-		bus.ring = base_request.at("is_roundtrip"s).AsBool();
+		// Запросы участка массива base_requests в исходном порядке. Названия остановок
+		// участка собираются в собственный пул, чтобы потоки не обращались к общему
+		struct ParsedRequests {
+			std::vector<BaseRequestStop> stops;
+			std::vector<BaseRequestBus> buses;
+			// i-й элемент равен true, если i-й запрос участка описывает остановку
+			std::vector<bool> is_stop;
+			util::StringPool stop_names;
+
+			tc::StopId GetStopId(std::string_view name) {
+				return stop_names.Intern(name);
+			}
 
-		std::vector<std::string> bus_stops;
-		for (const auto& stop : base_request.at("stops"s).AsArray()) {
-			bus_stops.push_back(stop.AsString());
-		}
-		bus.stops = std::move(bus_stops);
+			void AddStop(BaseRequestStop stop) {
+				stops.push_back(std::move(stop));
+				is_stop.push_back(true);
+			}
 
-		return bus;
-	}
+			void AddBus(BaseRequestBus bus) {
+				buses.push_back(std::move(bus));
+				is_stop.push_back(false);
+			}
 
-	BaseRequestStop JsonReader::ReadBaseRequestStop(const json::Dict& base_request) {
-		BaseRequestStop stop;
+			void Finish() {
+			}
 
-		stop.name = base_request.at("name"s).AsString();
-		stop.coordinates.lat = base_request.at("latitude"s).AsDouble();
-		stop.coordinates.lng = base_request.at("longitude"s).AsDouble();
+			// Передаёт запросы в sink в исходном порядке, заменяя идентификаторы названий
+			// остановок из пула участка идентификаторами, выданными sink
+			template <typename Sink>
+			void MoveTo(Sink& sink) {
+				std::vector<tc::StopId> sink_ids;
+				sink_ids.reserve(stop_names.Size());
+				for (tc::StopId id = 0; id < stop_names.Size(); ++id) {
+					sink_ids.push_back(sink.GetStopId(stop_names.Get(id)));
+				}
 
-		std::vector<std::pair<std::string, uint32_t>> distances;
-		for (const auto& [to, distance] : base_request.at("road_distances"s).AsMap()) {
-			distances.emplace_back(to, distance.AsInt());
-		}
-		stop.distances = std::move(distances);
+				auto stop = stops.begin();
+				auto bus = buses.begin();
+				for (const bool next_is_stop : is_stop) {
+					if (next_is_stop) {
+						stop->id = sink_ids[stop->id];
+						for (auto& [to, distance] : stop->distances) {
+							to = sink_ids[to];
+						}
+						sink.AddStop(std::move(*stop++));
+					}
+					else {
+						for (auto& id : bus->stops) {
+							id = sink_ids[id];
+						}
+						sink.AddBus(std::move(*bus++));
+					}
+				}
+			}
+		};
 
-		return stop;
-	}
+		// Собирает запросы base_requests из событий парсера и передаёт их в Sink
+		// (CatalogueLoader или ParsedRequests) по мере разбора. Названия остановок
+		// заменяются идентификаторами, которые выдаёт Sink.
+		// Как и при чтении через json::Dict, из повторяющихся ключей запроса действует первый,
+		// а отсутствующее или имеющее неверный тип поле запроса - ошибка разбора
+		template <typename Sink>
+		class BaseRequestsHandler final : public json::Handler {
+		public:
+			// request_depth - глубина вложенности словаря с отдельным запросом
+			BaseRequestsHandler(Sink& sink, int request_depth)
+				: sink_(sink)
+				, request_depth_(request_depth) {
+			}
 
-	StatRequest JsonReader::ReadStatRequest(const json::Dict& stat_request) {
-		StatRequest request;
+			void Null() override {
+				CheckKind(Kind::NULL_VALUE);
+			}
 
-		request.id = stat_request.at("id"s).AsInt();
+			void Bool(bool value) override {
+				CheckKind(Kind::BOOL);
+				if (depth_ == request_depth_ && field_ == Field::IS_ROUNDTRIP) {
+					bus_.ring = value;
+				}
+			}
 
-		const auto& stat_request_type = stat_request.at("type"s).AsString();
-		if (stat_request_type == "Bus"s) {
-			request.type = StatRequest::Type::BUS;
-		}
-		else if (stat_request_type == "Stop"s) {
-			request.type = StatRequest::Type::STOP;
-		}
-		else if (stat_request_type == "Map"s) {
-			request.type = StatRequest::Type::MAP;
-		}
-		else {
-			assert(false);
-		}
+			void Int(std::int64_t value) override {
+				CheckKind(Kind::INT);
+				if (depth_ == request_depth_ + 1 && field_ == Field::ROAD_DISTANCES) {
+					if (value < 0 || value > std::numeric_limits<uint32_t>::max()) {
+						Invalidate(Field::ROAD_DISTANCES, "contains a road distance out of range"sv);
+						return;
+					}
+					stop_.distances.emplace_back(distance_to_, static_cast<uint32_t>(value));
+				}
+				else {
+					SetCoordinate(static_cast<double>(value));
+				}
+			}
 
-		if (stat_request_type != "Map"s) {
-			request.name = stat_request.at("name"s).AsString();
-		}
+			void Double(double value) override {
+				CheckKind(Kind::DOUBLE);
+				SetCoordinate(value);
+			}
 
-		return request;
-	}
+			void String(std::string_view value) override {
+				CheckKind(Kind::STRING);
+				if (depth_ == request_depth_) {
+					if (field_ == Field::TYPE) {
+						type_ = static_cast<Type>(TYPES.Find(value));
+					}
+					else if (field_ == Field::NAME) {
+						name_ = value;
+					}
+				}
+				else if (depth_ == request_depth_ + 1 && field_ == Field::STOPS) {
+					bus_.stops.push_back(sink_.GetStopId(value));
+				}
+			}
+
+			void StartArray() override {
+				CheckKind(Kind::ARRAY);
+				++depth_;
+			}
+
+			void EndArray() override {
+				if (--depth_ == 0) {
+					sink_.Finish();
+				}
+			}
+
+			void StartDict() override {
+				CheckKind(Kind::DICT);
+				if (++depth_ == request_depth_) {
+					type_ = Type::OTHER;
+					name_.clear();
+					stop_ = {};
+					bus_ = {};
+					field_ = Field::OTHER;
+					seen_ = 0;
+					invalid_ = 0;
+				}
+			}
+
+			void Key(std::string_view key) override {
+				if (depth_ == request_depth_) {
+					field_ = ToField(key);
+					if (field_ != Field::OTHER) {
+						// Значение повторного ключа пропускается
+						if (seen_ & Bit(field_)) {
+							field_ = Field::OTHER;
+						}
+						seen_ |= Bit(field_);
+					}
+				}
+				else if (depth_ == request_depth_ + 1 && field_ == Field::ROAD_DISTANCES) {
+					distance_to_ = sink_.GetStopId(key);
+				}
+			}
+
+			void EndDict() override {
+				if (depth_-- == request_depth_) {
+					AddRequest();
+				}
+			}
+
+		private:
+			// Порядок элементов совпадает с порядком ключей в FIELD_NAMES
+			enum class Field {
+				TYPE,
+				NAME,
+				LATITUDE,
+				LONGITUDE,
+				ROAD_DISTANCES,
+				STOPS,
+				IS_ROUNDTRIP,
+				OTHER
+			};
+
+			static constexpr std::array<std::string_view, 7> FIELD_NAMES{ {
+				"type"sv, "name"sv, "latitude"sv, "longitude"sv, "road_distances"sv, "stops"sv, "is_roundtrip"sv
+			} };
+			static constexpr json::KeyTable<7> FIELDS{ FIELD_NAMES };
+
+			// Порядок элементов совпадает с порядком ключей в TYPES
+			enum class Type {
+				STOP,
+				BUS,
+				OTHER
+			};
+
+			static constexpr json::KeyTable<2> TYPES{ { "Stop"sv, "Bus"sv } };
+
+			// Тип значения JSON
+			enum class Kind {
+				NULL_VALUE,
+				BOOL,
+				INT,
+				DOUBLE,
+				STRING,
+				ARRAY,
+				DICT
+			};
+
+			Sink& sink_;
+			const int request_depth_;
+			int depth_ = 0;
+			Field field_ = Field::OTHER;
+
+			// Поля текущего запроса
+			Type type_ = Type::OTHER;
+			std::string name_;
+			tc::StopId distance_to_ = 0;
+			BaseRequestStop stop_;
+			BaseRequestBus bus_;
+			// Поля, которые встретились в запросе, и поля с неверным значением. Номер бита - номер поля
+			uint32_t seen_ = 0;
+			uint32_t invalid_ = 0;
+			// Описания ошибок полей с неверным значением
+			std::array<std::string_view, FIELD_NAMES.size()> errors_;
+
+			static Field ToField(std::string_view key) {
+				return static_cast<Field>(FIELDS.Find(key));
+			}
+
+			static uint32_t Bit(Field field) {
+				return field == Field::OTHER ? 0 : 1u << static_cast<int>(field);
+			}
+
+			// Ожидаемый тип значения поля запроса
+			static bool IsExpected(Field field, Kind kind) {
+				switch (field)
+				{
+				case Field::TYPE:
+				case Field::NAME:
+					return kind == Kind::STRING;
+				case Field::LATITUDE:
+				case Field::LONGITUDE:
+					return kind == Kind::INT || kind == Kind::DOUBLE;
+				case Field::ROAD_DISTANCES:
+					return kind == Kind::DICT;
+				case Field::STOPS:
+					return kind == Kind::ARRAY;
+				case Field::IS_ROUNDTRIP:
+					return kind == Kind::BOOL;
+				default:
+					return true;
+				}
+			}
+
+			// Проверяет тип очередного значения: элемента base_requests, значения поля запроса
+			// или элемента массива stops и словаря road_distances. Ошибка поля откладывается
+			// до конца запроса, так как поле может не относиться к запросу этого типа
+			void CheckKind(Kind kind) {
+				if (depth_ == request_depth_ - 2) {
+					if (kind != Kind::ARRAY) {
+						throw json::ParsingError("base_requests is not an array"s);
+					}
+				}
+				else if (depth_ == request_depth_ - 1) {
+					if (kind != Kind::DICT) {
+						throw json::ParsingError("Base request is not a dict"s);
+					}
+				}
+				else if (depth_ == request_depth_) {
+					if (!IsExpected(field_, kind)) {
+						Invalidate(field_, "has invalid type"sv);
+					}
+				}
+				else if (depth_ == request_depth_ + 1) {
+					if (field_ == Field::STOPS && kind != Kind::STRING) {
+						Invalidate(field_, "contains a stop name that is not a string"sv);
+					}
+					else if (field_ == Field::ROAD_DISTANCES && kind != Kind::INT) {
+						Invalidate(field_, "contains a road distance that is not an integer"sv);
+					}
+				}
+			}
+
+			void Invalidate(Field field, std::string_view error) {
+				if (field == Field::OTHER || (invalid_ & Bit(field))) {
+					return;
+				}
+				invalid_ |= Bit(field);
+				errors_[static_cast<size_t>(field)] = error;
+			}
+
+			void SetCoordinate(double value) {
+				if (depth_ != request_depth_) {
+					return;
+				}
+				if (field_ == Field::LATITUDE) {
+					stop_.coordinates.lat = value;
+				}
+				else if (field_ == Field::LONGITUDE) {
+					stop_.coordinates.lng = value;
+				}
+			}
+
+			// Бросает исключение, если поля нет в запросе или его значение неверно
+			void Require(Field field) const {
+				const std::string_view name = FIELD_NAMES[static_cast<size_t>(field)];
+				if ((seen_ & Bit(field)) == 0) {
+					throw json::ParsingError("Base request has no field "s + std::string(name));
+				}
+				if (invalid_ & Bit(field)) {
+					throw json::ParsingError("Base request field "s + std::string(name) + " "s + std::string(errors_[static_cast<size_t>(field)]));
+				}
+			}
+
+			void AddRequest() {
+				Require(Field::TYPE);
+				switch (type_)
+				{
+				case Type::STOP:
+					Require(Field::NAME);
+					Require(Field::LATITUDE);
+					Require(Field::LONGITUDE);
+					Require(Field::ROAD_DISTANCES);
+					RemoveRepeatedDistances();
+					stop_.id = sink_.GetStopId(name_);
+					sink_.AddStop(std::move(stop_));
+					break;
+				case Type::BUS:
+					Require(Field::NAME);
+					Require(Field::STOPS);
+					Require(Field::IS_ROUNDTRIP);
+					bus_.name = std::move(name_);
+					sink_.AddBus(std::move(bus_));
+					break;
+				default:
+					throw json::ParsingError("Unknown base request type"s);
+				}
+			}
+
+			// Из повторяющихся ключей road_distances действует первый
+			void RemoveRepeatedDistances() {
+				auto& distances = stop_.distances;
+				if (distances.size() < 2) {
+					return;
+				}
+				std::stable_sort(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs) {
+					return lhs.first < rhs.first;
+				});
+				distances.erase(std::unique(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs) {
+					return lhs.first == rhs.first;
+				}), distances.end());
+			}
+		};
+
+		// Положение массива base_requests в документе
+		struct BaseRequestsLayout {
+			// Массив занимает символы [begin, end), от '[' до ']' включительно
+			size_t begin = 0;
+			size_t end = 0;
+			// Границы элементов массива, без разделяющих запятых
+			std::vector<std::pair<size_t, size_t>> elements;
+		};
+
+		// Находит массив base_requests корневого словаря, просматривая только структурный индекс документа.
+		// Документ можно передавать по мере получения: границы элементов массива добавляются в layout
+		// сразу, как только элемент получен целиком. Просмотр завершается неудачей, если массива нет
+		// или его нельзя разделить на элементы без полного разбора (например, из-за синтаксической ошибки)
+		class BaseRequestsScanner {
+		public:
+			enum class State {
+				SCANNING,
+				FOUND,
+				FAILED
+			};
+
+			// document - полученное начало документа, complete равно true, если документ получен целиком
+			State Scan(std::string_view document, bool complete) {
+				if (state_ != State::SCANNING) {
+					return state_;
+				}
+				indexer_.Extend(document, complete);
+				while (indexer_.Next()) {
+					for (const uint32_t offset : indexer_) {
+						if (!ScanToken(document, indexer_.Base() + offset)) {
+							return state_;
+						}
+					}
+				}
+				if (complete || indexer_.Stopped()) {
+					state_ = State::FAILED;
+				}
+				return state_;
+			}
+
+			const BaseRequestsLayout& GetLayout() const {
+				return layout_;
+			}
+
+		private:
+			json::StructuralIndexer indexer_{ {} };
+			State state_ = State::SCANNING;
+			BaseRequestsLayout layout_;
+
+			int depth_ = 0;
+			bool in_string_ = false;
+			size_t string_begin_ = 0;
+			// Последняя строка корневого словаря; перед двоеточием это ключ
+			size_t key_begin_ = 0;
+			size_t key_end_ = 0;
+			bool expect_array_ = false;
+			bool in_array_ = false;
+			size_t element_begin_ = 0;
+			// Число значений в текущем элементе массива: в корректном документе ровно одно
+			int element_values_ = 0;
+
+			// Возвращает false, если просмотр завершён
+			bool ScanToken(std::string_view document, size_t pos) {
+				const char c = document[pos];
+
+				if (in_string_) {
+					// Внутри строки индекс содержит также escape-последовательности и переводы строк
+					if (c == '"') {
+						in_string_ = false;
+						if (depth_ == 1) {
+							key_begin_ = string_begin_;
+							key_end_ = pos;
+						}
+					}
+					return true;
+				}
+
+				if (expect_array_) {
+					if (c != '[') {
+						return Fail();
+					}
+					expect_array_ = false;
+					in_array_ = true;
+					layout_.begin = pos;
+					++depth_;
+					return true;
+				}
+
+				// Любой другой токен на уровне элементов массива (в том числе ошибочный) считается значением
+				if (in_array_ && depth_ == 2 && c != ',' && c != ']' && c != '}') {
+					if (element_values_++ == 0) {
+						element_begin_ = pos;
+					}
+				}
+
+				switch (c) {
+				case '"':
+					in_string_ = true;
+					string_begin_ = pos + 1;
+					break;
+				case '{':
+				case '[':
+					++depth_;
+					break;
+				case '}':
+				case ']':
+					if (--depth_ == 1 && in_array_) {
+						if (c != ']') {
+							return Fail();
+						}
+						if (element_values_ == 1) {
+							layout_.elements.emplace_back(element_begin_, pos);
+						}
+						else if (element_values_ != 0 || !layout_.elements.empty()) {
+							return Fail();
+						}
+						layout_.end = pos + 1;
+						state_ = State::FOUND;
+						return false;
+					}
+					break;
+				case ',':
+					if (in_array_ && depth_ == 2) {
+						if (element_values_ != 1) {
+							return Fail();
+						}
+						layout_.elements.emplace_back(element_begin_, pos);
+						element_values_ = 0;
+					}
+					break;
+				case ':':
+					if (depth_ == 1 && document.substr(key_begin_, key_end_ - key_begin_) == "base_requests"sv) {
+						expect_array_ = true;
+					}
+					break;
+				default:
+					break;
+				}
+				return true;
+			}
+
+			bool Fail() {
+				state_ = State::FAILED;
+				return false;
+			}
+		};
+
+		// Глубина вложенности словаря с отдельным запросом в массиве base_requests
+		constexpr int BASE_REQUEST_DEPTH = 2;
+		// То же при разборе отдельного элемента массива: словарь запроса - корень элемента
+		constexpr int ELEMENT_REQUEST_DEPTH = 1;
+
+		/*
+		 * Разбирает элементы массива base_requests по мере того, как они найдены в документе.
+		 * Без пула из нескольких потоков элементы сразу разбираются в общий буфер запросов. Иначе они
+		 * собираются в участки не меньше CHUNK_SIZE байт, копии которых разбираются в пуле потоков.
+		 * В справочник запросы передаются в исходном порядке только при вызове Finish, когда массив
+		 * найден целиком: если просмотр документа прервётся, справочник останется неизменным
+		 */
+		class BaseRequestsLoader {
+		public:
+			BaseRequestsLoader(tc::TransportCatalogue& transport_catalogue, util::ThreadPool* thread_pool)
+				: loader_(transport_catalogue)
+				, thread_pool_(thread_pool != nullptr && thread_pool->Size() > 1 ? thread_pool : nullptr) {
+			}
+
+			// Разбирает элементы, найденные после предыдущего вызова
+			void Load(std::string_view document, const BaseRequestsLayout& layout) {
+				const auto& elements = layout.elements;
+				if (thread_pool_ == nullptr) {
+					// Ошибка в элементе откладывается до Finish, как и ошибка участка в пуле:
+					// синтаксическая ошибка дальше в документе должна быть найдена раньше
+					for (; loaded_ < elements.size() && !failed_; ++loaded_) {
+						const auto [begin, end] = elements[loaded_];
+						try {
+							json::Parse(document.substr(begin, end - begin), handler_);
+						}
+						catch (const json::ParsingError&) {
+							failed_ = true;
+						}
+					}
+					return;
+				}
 
-	RenderSettings JsonReader::ReadRenderSettings(const json::Dict& render_settings) {
-		RenderSettings settings;
-		settings.width = render_settings.at("width"s).AsDouble();
-		settings.height = render_settings.at("height"s).AsDouble();
-		settings.padding = render_settings.at("padding"s).AsDouble();
-		settings.line_width = render_settings.at("line_width"s).AsDouble();
-		settings.stop_radius = render_settings.at("stop_radius"s).AsDouble();
-		settings.bus_label_font_size = render_settings.at("bus_label_font_size"s).AsInt();
-		settings.bus_label_offset = ReadOffset(render_settings.at("bus_label_offset"s).AsArray());
-		settings.stop_label_font_size = render_settings.at("stop_label_font_size"s).AsInt();
-		settings.stop_label_offset = ReadOffset(render_settings.at("stop_label_offset"s).AsArray());
-		settings.underlayer_color = ReadColor(render_settings.at("underlayer_color"s));
-		settings.underlayer_width = render_settings.at("underlayer_width"s).AsDouble();
-		settings.color_palette = ReadColorPalette(render_settings.at("color_palette"s).AsArray());
-
-		return settings;
+				size_t first = loaded_;
+				for (size_t last = loaded_; last < elements.size(); ++last) {
+					if (elements[last].second - elements[first].first >= CHUNK_SIZE) {
+						Submit(document, elements, first, last + 1);
+						first = last + 1;
+					}
+				}
+			}
+
+			// Завершает загрузку массива, найденного в документе целиком
+			void Finish(std::string_view document, const BaseRequestsLayout& layout) {
+				Load(document, layout);
+				if (thread_pool_ == nullptr) {
+					if (failed_) {
+						ParseSequentially(document, layout);
+						return;
+					}
+					requests_.MoveTo(loader_);
+					loader_.Finish();
+					return;
+				}
+
+				if (loaded_ < layout.elements.size()) {
+					Submit(document, layout.elements, loaded_, layout.elements.size());
+				}
+				std::vector<ParsedRequests> requests;
+				requests.reserve(chunks_.size());
+				for (auto& chunk : chunks_) {
+					try {
+						requests.push_back(chunk.get());
+					}
+					catch (const json::ParsingError&) {
+						failed_ = true;
+					}
+				}
+
+				if (failed_) {
+					ParseSequentially(document, layout);
+					return;
+				}
+				for (auto& chunk : requests) {
+					chunk.MoveTo(loader_);
+				}
+				loader_.Finish();
+			}
+
+		private:
+			static constexpr size_t CHUNK_SIZE = 1 << 18;
+
+			CatalogueLoader loader_;
+			util::ThreadPool* thread_pool_;
+			// Запросы, разобранные без пула
+			ParsedRequests requests_;
+			BaseRequestsHandler<ParsedRequests> handler_{ requests_, ELEMENT_REQUEST_DEPTH };
+			// Число элементов, разобранных или переданных в пул
+			size_t loaded_ = 0;
+			std::vector<std::future<ParsedRequests>> chunks_;
+			// Разбор какого-то элемента завершился ошибкой
+			bool failed_ = false;
+
+			// Разбирает массив заново последовательно, чтобы выбросить исключение с описанием первой ошибки
+			void ParseSequentially(std::string_view document, const BaseRequestsLayout& layout) {
+				BaseRequestsHandler<CatalogueLoader> handler(loader_, BASE_REQUEST_DEPTH);
+				json::Parse(document.substr(layout.begin, layout.end - layout.begin), handler);
+			}
+
+			// Передаёт в пул копию элементов [first, last), чтобы документ мог расти во время разбора
+			void Submit(std::string_view document, const std::vector<std::pair<size_t, size_t>>& elements, size_t first, size_t last) {
+				const size_t base = elements[first].first;
+				std::string text(document.substr(base, elements[last - 1].second - base));
+				std::vector<std::pair<size_t, size_t>> bounds;
+				bounds.reserve(last - first);
+				for (size_t i = first; i < last; ++i) {
+					bounds.emplace_back(elements[i].first - base, elements[i].second - base);
+				}
+
+				chunks_.push_back(thread_pool_->Submit([text = std::move(text), bounds = std::move(bounds)] {
+					ParsedRequests requests;
+					BaseRequestsHandler<ParsedRequests> handler(requests, ELEMENT_REQUEST_DEPTH);
+					const std::string_view chunk = text;
+					for (const auto& [begin, end] : bounds) {
+						json::Parse(chunk.substr(begin, end - begin), handler);
+					}
+					return requests;
+				}));
+				loaded_ = last;
+			}
+		};
+
+	} // namespace
+
+	JsonReader::JsonReader(std::istream& input, util::ThreadPool* thread_pool)
+		: input_(&input)
+		, thread_pool_(thread_pool) {
 	}
 
-	svg::Point JsonReader::ReadOffset(const json::Array& offset) {
-		return svg::Point(offset[0].AsDouble(), offset[1].AsDouble());
+	JsonReader::JsonReader(std::string_view document, util::ThreadPool* thread_pool)
+		: document_(document)
+		, thread_pool_(thread_pool) {
 	}
 
-	svg::Color JsonReader::ReadColor(const json::Node& color) {
-		if (color.IsString()) {
-			return color.AsString();
-		}
-		else if (color.IsArray()) {
-			const auto& color_array = color.AsArray();
-			if (color_array.size() == 3) {
-				return svg::Rgb(color_array[0].AsInt(), color_array[1].AsInt(), color_array[2].AsInt());
-			}
-			else if (color_array.size() == 4) {
-				return svg::Rgba(color_array[0].AsInt(), color_array[1].AsInt(), color_array[2].AsInt(), color_array[3].AsDouble());
+	Input JsonReader::Read(tc::TransportCatalogue& transport_catalogue) {
+		BaseRequestsScanner scanner;
+		BaseRequestsLoader loader(transport_catalogue, thread_pool_);
+
+		std::string buffer;
+		std::string_view document = document_;
+		if (input_ != nullptr) {
+			// Поток читается в отдельном потоке выполнения, а найденные в прочитанной части
+			// элементы base_requests разбираются, пока читается остальной документ
+			util::ReadAheadReader reader(*input_);
+			for (bool complete = false; !complete;) {
+				const auto block = reader.Next();
+				complete = block.empty();
+				buffer.append(block);
+				if (scanner.Scan(buffer, complete) != BaseRequestsScanner::State::FAILED) {
+					loader.Load(buffer, scanner.GetLayout());
+				}
 			}
+			input_wait_time_ = reader.WaitTime();
+			document = buffer;
 		}
-		assert(false);
-	}
 
-	std::vector<svg::Color> JsonReader::ReadColorPalette(const json::Array& palette) {
-		std::vector<svg::Color> colors;
-		colors.reserve(palette.size());
-		for (const auto& color : palette) {
-			colors.push_back(ReadColor(color));
+		if (scanner.Scan(document, true) == BaseRequestsScanner::State::FOUND) {
+			const auto& layout = scanner.GetLayout();
+			loader.Finish(document, layout);
+
+			// Остальные разделы читаются из ленивого документа, вместо base_requests - пустой массив
+			std::string rest;
+			rest.reserve(document.size() - (layout.end - layout.begin) + 2);
+			rest.append(document.substr(0, layout.begin)).append("[]"sv).append(document.substr(layout.end));
+			const auto lazy_document = json::LoadLazy(rest);
+			return json::BindLazy<Input>(lazy_document.GetRoot());
 		}
-		return colors;
+
+		// Массив base_requests не удалось выделить по структурному индексу (например, между элементами
+		// есть экранированный пробельный символ): он разбирается по тексту, найденному в ленивом документе.
+		// Уже разобранные элементы в справочник не попали и отбрасываются
+		const auto lazy_document = json::LoadLazy(document);
+		const auto root = lazy_document.GetRoot();
+		if (root.Contains("base_requests"sv)) {
+			CatalogueLoader catalogue_loader(transport_catalogue);
+			BaseRequestsHandler<CatalogueLoader> handler(catalogue_loader, BASE_REQUEST_DEPTH);
+			json::Parse(root.At("base_requests"sv).Text(), handler);
+		}
+		return json::BindLazy<Input>(root);
 	}
 
 	// ---------------------- Output ----------------------
 
 	namespace {
 
+		// Ключи словаря выводятся по возрастанию, как при выводе json::Dict
 		struct StatResultPrinter {
-			json::BuilderDict& dict;
+			json::Writer& writer;
+			RequestId request_id;
+			util::DoubleFormat double_format;
 
 			void operator()(std::monostate) const {
-				dict.Key("error_message"s).Value("not found"s);
+				writer.Key("error_message"sv).Value("not found"sv);
+				PrintRequestId();
 			}
 
-			void operator()(tc::BusInfo bus_info) const {
-				dict.Key("curvature"s).Value(bus_info.curvature);
-				dict.Key("route_length"s).Value(bus_info.length);
-				dict.Key("stop_count"s).Value(bus_info.stops);
-				dict.Key("unique_stop_count"s).Value(bus_info.unique_stops);
+			void operator()(const tc::BusInfo& bus_info) const {
+				writer.Key("curvature"sv).Value(bus_info.curvature);
+				PrintRequestId();
+				writer.Key("route_length"sv).Value(bus_info.length);
+				writer.Key("stop_count"sv).Value(bus_info.stops);
+				writer.Key("unique_stop_count"sv).Value(bus_info.unique_stops);
 			}
 
-			void operator()(tc::StopInfo stop_info) const {
-				auto json_array = dict.Key("buses"s).StartArray();
-				for (auto& bus : stop_info.buses) {
-					json_array.Value(std::move(bus));
+			void operator()(const tc::StopInfo& stop_info) const {
+				writer.Key("buses"sv).StartArray();
+				for (const auto& bus : stop_info.buses) {
+					writer.Value(bus);
 				}
-				json_array.EndArray();
+				writer.EndArray();
+				PrintRequestId();
+			}
+
+			void operator()(const std::shared_ptr<const svg::Document>& map) const {
+				writer.Key("map"sv).StringValue([&](std::ostream& output) {
+					map->Render(output, double_format);
+				});
+				PrintRequestId();
+			}
+
+			void operator()(const MapFile& map_file) const {
+				writer.Key("map_file"sv).StartDict();
+				writer.Key("hash"sv).Value(map_file.hash);
+				writer.Key("path"sv).Value(map_file.path);
+				writer.Key("size"sv).Value(map_file.size);
+				writer.EndDict();
+				PrintRequestId();
 			}
 
-			void operator()(std::string map_info) const {
-				dict.Key("map"s).Value(std::move(map_info));
+			void PrintRequestId() const {
+				writer.Key("request_id"sv).Value(request_id);
 			}
 		};
 
+		void WriteResult(json::Writer& writer, const StatRequestResult& result, util::DoubleFormat double_format) {
+			writer.StartDict();
+			std::visit(StatResultPrinter{ writer, result.request_id, double_format }, result.result);
+			writer.EndDict();
+		}
+
 	} // namespace
 
-	JsonWriter::JsonWriter(std::ostream& output) 
-		: output_(output) {
+	JsonWriter::JsonWriter(std::ostream& output, json::PrintOptions options)
+		: options_(options)
+		, writer_(output, options) {
 	}
 
-	void JsonWriter::Write(const std::vector<StatRequestResult>& results) {
-		json::Builder json_builder;
-		
-		auto json_array = json_builder.StartArray();
-		for (const auto& result : results) {
-			auto json_dict = json_array.StartDict();
-			json_dict.Key("request_id"s).Value(result.request_id);		
-			std::visit(StatResultPrinter{ json_dict }, result.result);
-			json_dict.EndDict();
-		}
-		json_array.EndArray();
+	void JsonWriter::Start() {
+		writer_.StartArray();
+	}
+
+	void JsonWriter::Write(const StatRequestResult& result) {
+		WriteResult(writer_, result, options_.double_format);
+	}
+
+	void JsonWriter::WriteFormatted(std::string_view items, size_t count) {
+		writer_.Items(items, count);
+	}
+
+	void JsonWriter::Finish() {
+		writer_.EndArray();
+	}
 
-		json::Print(json::Document(json_builder.Build()), output_);
+	std::string JsonWriter::Format(const StatRequestResult& result, size_t index) const {
+		std::ostringstream output;
+		auto items = json::Writer::ArrayItems(output, options_, index);
+		WriteResult(items, result, options_.double_format);
+		return output.str();
 	}
 
-} // namespace tc
+} // namespace tc
\ No newline at end of file
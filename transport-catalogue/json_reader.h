@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -9,6 +12,9 @@
 #include "geo.h"
 #include "json.h"
 #include "map_renderer.h"
+#include "map_store.h"
+#include "thread_pool.h"
+#include "transport_catalogue.h"
 
 namespace io {
 
@@ -16,16 +22,17 @@ namespace io {
 
 	using RequestId = int;
 
+	// Остановки в запросах задаются идентификаторами названий, выданными при разборе
 	struct BaseRequestStop {
-		std::string name;
+		tc::StopId id = 0;
 		geo::Coordinates coordinates;
-		std::vector<std::pair<std::string, uint32_t>> distances;
+		std::vector<std::pair<tc::StopId, uint32_t>> distances;
 	};
 
 	struct BaseRequestBus {
 		std::string name;
 		bool ring = false;
-		std::vector<std::string> stops;
+		std::vector<tc::StopId> stops;
 	};
 
 	struct StatRequest {
@@ -41,45 +48,60 @@ namespace io {
 	};
 
 	struct Input {
-		std::vector<BaseRequestStop> stops;
-		std::vector<BaseRequestBus> buses;
 		std::vector<StatRequest> stat_requests;
 		RenderSettings render_settings;
 	};
 
 	class JsonReader {
 	public:
-		JsonReader(std::istream& input);
-		Input Read();
+		// Если задан пул из нескольких потоков, элементы массива base_requests разбираются параллельно
+		JsonReader(std::istream& input, util::ThreadPool* thread_pool = nullptr);
+		// Документ разбирается на месте и должен оставаться действительным во время Read
+		JsonReader(std::string_view document, util::ThreadPool* thread_pool = nullptr);
+		// Запросы base_requests добавляются в transport_catalogue в порядке их следования в документе.
+		// Поток читается в отдельном потоке выполнения, параллельно с разбором прочитанной части
+		Input Read(tc::TransportCatalogue& transport_catalogue);
+
+		// Время, которое Read провёл в ожидании чтения входного потока
+		std::chrono::nanoseconds GetInputWaitTime() const {
+			return input_wait_time_;
+		}
 
 	private:
-		std::istream& input_;
-
-		static BaseRequestBus ReadBaseRequestBus(const json::Dict& base_request);
-		static BaseRequestStop ReadBaseRequestStop(const json::Dict& base_request);
-		static StatRequest ReadStatRequest(const json::Dict& stat_request);
-		static RenderSettings ReadRenderSettings(const json::Dict& render_settings);
-
-		static svg::Point ReadOffset(const json::Array& offset);
-		static svg::Color ReadColor(const json::Node& color);
-		static std::vector<svg::Color> ReadColorPalette(const json::Array& palette);
-
+		// Если входной поток не задан, читается document_
+		std::istream* input_ = nullptr;
+		std::string_view document_;
+		util::ThreadPool* thread_pool_;
+		std::chrono::nanoseconds input_wait_time_{ 0 };
 	};
 
 	// ---------------------- Output ----------------------
 
+	// Карта хранится в виде SVG-документа и выводится в строку ответа при записи.
+	// Один документ может быть общим для нескольких запросов карты.
+	// Карта, сохранённая в файл, выводится описанием файла
 	struct StatRequestResult {
 		RequestId request_id = 0;
-		std::variant<std::monostate, tc::BusInfo, tc::StopInfo, std::string> result;
+		std::variant<std::monostate, tc::BusInfo, tc::StopInfo, std::shared_ptr<const svg::Document>, MapFile> result;
 	};
 
 	class JsonWriter {
 	public:
-		JsonWriter(std::ostream& output);
-		void Write(const std::vector<StatRequestResult>& results);
+		JsonWriter(std::ostream& output, json::PrintOptions options = {});
+
+		// Пошаговый вывод массива результатов: Start, затем результаты в порядке следования, затем Finish
+		void Start();
+		void Write(const StatRequestResult& result);
+		// Выводит count результатов, отформатированных Format
+		void WriteFormatted(std::string_view items, size_t count);
+		void Finish();
+
+		// Форматирует результат с номером index в массиве, не выводя его. Можно вызывать из нескольких потоков
+		std::string Format(const StatRequestResult& result, size_t index) const;
 
 	private:
-		std::ostream& output_;
+		json::PrintOptions options_;
+		json::Writer writer_;
 	};
 
 } // namespace tc
\ No newline at end of file
@@ -1,84 +1,289 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
-#include <sstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "map_store.h"
+#include "mapped_file.h"
+#include "output_buffer.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 
 using namespace io;
 using namespace tc;
+using namespace std::literals;
 
-TransportCatalogue InitTransportCatalogue(std::vector<BaseRequestStop> stops, std::vector<BaseRequestBus> buses) {
-	TransportCatalogue transport_catalogue;
+// Параметры вывода, задаваемые в командной строке
+struct Options {
+	json::PrintOptions print;
+	// Каталог, в который сохраняются карты; если не задан, карты выводятся в ответе
+	std::optional<std::filesystem::path> map_dir;
+	// Файл с запросами; если не задан, запросы читаются из stdin
+	std::optional<std::string> input;
+	// Читать файл с запросами через read вместо отображения в память
+	bool no_mmap = false;
+	// Выводить в stderr время чтения запросов и время ожидания ввода
+	bool input_stats = false;
+	// Вычислять сведения о маршруте при первом запросе вместо подготовки всех маршрутов после загрузки
+	TransportCatalogue::BusInfoMode bus_info_mode = TransportCatalogue::BusInfoMode::EAGER;
+};
 
-	for (auto& stop : stops) {
-		transport_catalogue.AddStop(stop.name, std::move(stop.coordinates));
-	}
-	for (auto& stop : stops) {
-		for (auto& [to, distance] : stop.distances) {
-			transport_catalogue.AddDistance(stop.name, to, distance);
+std::optional<Options> ParseCommandLine(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--compact"sv) {
+			options.print.compact = true;
+		}
+		else if (arg == "--shortest-numbers"sv) {
+			options.print.double_format = util::DoubleFormat::SHORTEST;
+		}
+		else if (arg == "--lazy-bus-info"sv) {
+			options.bus_info_mode = TransportCatalogue::BusInfoMode::LAZY;
+		}
+		else if (arg == "--input-stats"sv) {
+			options.input_stats = true;
+		}
+		else if (arg == "--input"sv && i + 1 < argc) {
+			options.input = argv[++i];
+		}
+		else if (arg == "--no-mmap"sv) {
+			options.no_mmap = true;
 		}
+		else if (arg == "--map-dir"sv && i + 1 < argc) {
+			options.map_dir = argv[++i];
+		}
+		else {
+			return std::nullopt;
+		}
+	}
+	return options;
+}
+
+// Справочник не меняется, поэтому карта одна для всех запросов: она строится при первом запросе
+// карты, а если задан map_store, то и сохраняется в файл один раз. Методы можно вызывать из нескольких потоков
+class MapCache {
+public:
+	MapCache(const TransportCatalogue& transport_catalogue, const MapRenderer& map_renderer, const MapStore* map_store)
+		: transport_catalogue_(transport_catalogue)
+		, map_renderer_(map_renderer)
+		, map_store_(map_store) {
+	}
+
+	const std::shared_ptr<const svg::Document>& GetDocument() {
+		std::call_once(document_flag_, [this] {
+			const auto buses = transport_catalogue_.GetBusesView();
+			document_ = std::make_shared<const svg::Document>(map_renderer_.Render(buses.GetBuses()));
+		});
+		return document_;
+	}
+
+	const MapStore* GetStore() const {
+		return map_store_;
 	}
-	for (auto& bus : buses) {
-		transport_catalogue.AddBus(std::move(bus.name), bus.ring, bus.stops);
+
+	const MapFile& GetFile() {
+		std::call_once(file_flag_, [this] {
+			file_ = map_store_->Save(*GetDocument());
+		});
+		return file_;
+	}
+
+private:
+	const TransportCatalogue& transport_catalogue_;
+	const MapRenderer& map_renderer_;
+	const MapStore* map_store_;
+
+	std::once_flag document_flag_;
+	std::shared_ptr<const svg::Document> document_;
+	std::once_flag file_flag_;
+	MapFile file_;
+};
+
+StatRequestResult ExecuteStatRequest(const StatRequest& request, const TransportCatalogue& transport_catalogue, MapCache& map_cache) {
+	StatRequestResult result;
+	result.request_id = request.id;
+
+	switch (request.type)
+	{
+	case StatRequest::Type::BUS:
+		if (auto info = transport_catalogue.GetBusInfo(request.name)) {
+			result.result = *std::move(info);
+		}
+		break;
+	case StatRequest::Type::STOP:
+		if (auto info = transport_catalogue.GetStopInfo(request.name)) {
+			result.result = *std::move(info);
+		}
+		break;
+	case StatRequest::Type::MAP:
+		if (map_cache.GetStore() == nullptr) {
+			result.result = map_cache.GetDocument();
+		}
+		else {
+			result.result = map_cache.GetFile();
+		}
+		break;
+	default:
+		assert(false);
 	}
 
-	return transport_catalogue;
+	return result;
 }
 
-std::vector<StatRequestResult> ExecuteStatRequests(const std::vector<StatRequest>& requests, const TransportCatalogue& transport_catalogue, const MapRenderer& map_renderer) {
-	std::vector<StatRequestResult> results;
-	results.reserve(requests.size());
-		
-	for (const auto& request : requests) {
-		StatRequestResult result;
-		result.request_id = request.id;
-		
-		switch (request.type)
-		{
-		case StatRequest::Type::BUS:
-			if (auto info = transport_catalogue.GetBusInfo(request.name)) {
-				result.result = *std::move(info);
-			}
-			break;
-		case StatRequest::Type::STOP:
-			if (auto info = transport_catalogue.GetStopInfo(request.name)) {
-				result.result = *std::move(info);
+// Ответ на запрос. Ответ, который ждёт вывода предыдущих, отформатирован заранее
+struct PendingResult {
+	StatRequestResult result;
+	std::optional<std::string> formatted;
+};
+
+// Выполняет запросы в пуле потоков и выводит ответы в порядке запросов, как только готовы ответ и все
+// предыдущие. Заранее форматируются только ответы, которые ждут вывода предыдущих. Ответ, очередь
+// которого уже подошла, и карта, которая может занимать мегабайты, выводятся сразу в поток вывода.
+// Одновременно обрабатывается не больше WINDOW_PER_THREAD запросов на поток, поэтому в памяти
+// хранится ограниченное число ответов. Вывод сбрасывается, если следующий ответ не готов в течение
+// FLUSH_DELAY: быстрые ответы выводятся вместе, а задержка вывода ограничена
+void WriteStatResults(const std::vector<StatRequest>& requests, const TransportCatalogue& transport_catalogue, MapCache& map_cache,
+	util::ThreadPool& thread_pool, JsonWriter& json_writer, std::ostream& output) {
+	const size_t WINDOW_PER_THREAD = 4;
+	const size_t window = thread_pool.Size() * WINDOW_PER_THREAD;
+	const auto FLUSH_DELAY = std::chrono::milliseconds(1);
+
+	// Номер ответа, который выводится следующим
+	std::atomic<size_t> written = 0;
+	std::deque<std::future<PendingResult>> pending;
+	size_t submitted = 0;
+	const auto submit = [&] {
+		pending.push_back(thread_pool.Submit([&, index = submitted] {
+			PendingResult pending_result{ ExecuteStatRequest(requests[index], transport_catalogue, map_cache), std::nullopt };
+			const bool is_map = std::holds_alternative<std::shared_ptr<const svg::Document>>(pending_result.result.result);
+			if (!is_map && index != written.load()) {
+				pending_result.formatted = json_writer.Format(pending_result.result, index);
 			}
-			break;
-		case StatRequest::Type::MAP:
-		{
-			auto buses = transport_catalogue.GetBuses();
-			const auto document = map_renderer.Render(std::move(buses));
+			return pending_result;
+		}));
+		++submitted;
+	};
 
-			std::ostringstream sstream;
-			document.Render(sstream);
-			result.result = sstream.str();
+	json_writer.Start();
+	try {
+		while (submitted < requests.size() && pending.size() < window) {
+			submit();
 		}
+		while (!pending.empty()) {
+			const PendingResult item = pending.front().get();
+			pending.pop_front();
+			if (submitted < requests.size()) {
+				submit();
+			}
 
-			break;
-		default:
-			assert(false);
+			if (item.formatted) {
+				json_writer.WriteFormatted(*item.formatted, 1);
+			}
+			else {
+				json_writer.Write(item.result);
+			}
+			++written;
+			if (!pending.empty() && pending.front().wait_for(FLUSH_DELAY) != std::future_status::ready) {
+				output.flush();
+			}
 		}
+	}
+	catch (...) {
+		// Задачи ссылаются на запросы и справочник, поэтому дожидаемся их завершения
+		for (const auto& task : pending) {
+			task.wait();
+		}
+		throw;
+	}
+	json_writer.Finish();
+}
 
-		results.push_back(std::move(result));
+int main(int argc, char* argv[]) {
+	const auto options = ParseCommandLine(argc, argv);
+	if (!options) {
+		std::cerr << "Usage: "sv << argv[0] << " [--compact] [--shortest-numbers] [--map-dir DIR] [--input FILE [--no-mmap]] [--input-stats] [--lazy-bus-info] [< input.json] > output.json"sv << std::endl;
+		return 1;
 	}
 
-	return results;
-}
+	util::ThreadPool thread_pool(std::max(1u, std::thread::hardware_concurrency()));
 
-int main() {	
-	JsonReader json_reader(std::cin);
-	auto input = json_reader.Read();
+	// Файл с запросами по умолчанию отображается в память и разбирается на месте
+	std::ifstream input_file;
+	std::optional<util::MappedFile> mapped_input;
+	if (options->input) {
+		try {
+			if (options->no_mmap) {
+				input_file.open(*options->input, std::ios::binary);
+				if (!input_file) {
+					throw std::system_error(errno, std::generic_category(), "Failed to open "s + *options->input);
+				}
+			}
+			else {
+				mapped_input.emplace(*options->input);
+			}
+		}
+		catch (const std::system_error& error) {
+			std::cerr << error.what() << std::endl;
+			return 1;
+		}
+	}
+
+	TransportCatalogue transport_catalogue;
+	JsonReader json_reader = mapped_input
+		? JsonReader(mapped_input->Data(), &thread_pool)
+		: JsonReader(options->input ? input_file : std::cin, &thread_pool);
+	const auto read_start = std::chrono::steady_clock::now();
+	auto input = json_reader.Read(transport_catalogue);
+	if (options->input_stats) {
+		const std::chrono::duration<double, std::milli> read_time = std::chrono::steady_clock::now() - read_start;
+		const std::chrono::duration<double, std::milli> wait_time = json_reader.GetInputWaitTime();
+		std::cerr << "Input read time: "sv << read_time.count() << " ms, wait time: "sv << wait_time.count() << " ms"sv << std::endl;
+	}
+	transport_catalogue.Finalize(options->bus_info_mode, &thread_pool);
 
-	const auto transport_catalogue = InitTransportCatalogue(std::move(input.stops), std::move(input.buses));
 	MapRenderer map_renderer(std::move(input.render_settings));
 
-	const auto results = ExecuteStatRequests(input.stat_requests, transport_catalogue, map_renderer);
+	std::optional<MapStore> map_store;
+	if (options->map_dir) {
+		map_store.emplace(*options->map_dir, options->print.double_format);
+	}
+	MapCache map_cache(transport_catalogue, map_renderer, map_store ? &*map_store : nullptr);
+
+	// Ответ записывается в stdout крупными блоками, минуя буфер std::cout
+	util::FdOutputBuffer output_buffer(fileno(stdout));
+	std::ostream output(&output_buffer);
+	JsonWriter json_writer(output, options->print);
+	try {
+		WriteStatResults(input.stat_requests, transport_catalogue, map_cache, thread_pool, json_writer, output);
+	}
+	catch (const std::runtime_error& error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
 
-	JsonWriter json_writer(std::cout);
-	json_writer.Write(results);
+	if (!output.flush()) {
+		std::cerr << "Failed to write output"sv << std::endl;
+		return 1;
+	}
 }
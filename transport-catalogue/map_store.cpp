@@ -0,0 +1,117 @@
+#include "map_store.h"
+
+#include <charconv>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <streambuf>
+#include <system_error>
+#include <utility>
+
+using namespace std::literals;
+
+namespace io {
+
+	namespace {
+
+		/*
+		 * Буфер потока, который передаёт данные в target блоками по BUFFER_SIZE байт,
+		 * вычисляя хеш FNV-1a и размер переданных данных
+		 */
+		class HashingBuffer : public std::streambuf {
+		public:
+			explicit HashingBuffer(std::streambuf& target)
+				: target_(target) {
+				setp(buffer_, buffer_ + BUFFER_SIZE);
+			}
+
+			std::uint64_t Hash() const {
+				return hash_;
+			}
+
+			std::uint64_t Size() const {
+				return size_;
+			}
+
+		protected:
+			int_type overflow(int_type ch) override {
+				if (sync() != 0) {
+					return traits_type::eof();
+				}
+				if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+					*pptr() = traits_type::to_char_type(ch);
+					pbump(1);
+				}
+				return traits_type::not_eof(ch);
+			}
+
+			int sync() override {
+				const std::streamsize count = pptr() - pbase();
+				for (const char* c = pbase(); c != pptr(); ++c) {
+					hash_ ^= static_cast<unsigned char>(*c);
+					hash_ *= 1099511628211u;
+				}
+				size_ += count;
+				setp(buffer_, buffer_ + BUFFER_SIZE);
+				return target_.sputn(buffer_, count) == count ? 0 : -1;
+			}
+
+		private:
+			static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+			std::streambuf& target_;
+			std::uint64_t hash_ = 14695981039346656037u;
+			std::uint64_t size_ = 0;
+			char buffer_[BUFFER_SIZE];
+		};
+
+		std::string ToHex(std::uint64_t value) {
+			std::string result(16, '0');
+			char buffer[16];
+			const auto end = std::to_chars(buffer, buffer + sizeof(buffer), value, 16).ptr;
+			result.replace(result.size() - (end - buffer), end - buffer, buffer, end - buffer);
+			return result;
+		}
+
+	} // namespace
+
+	MapStore::MapStore(std::filesystem::path directory, util::DoubleFormat double_format)
+		: directory_(std::move(directory))
+		, double_format_(double_format) {
+	}
+
+	MapFile MapStore::Save(const svg::Document& document) const {
+		std::error_code error;
+		std::filesystem::create_directories(directory_, error);
+		if (error) {
+			throw std::runtime_error("Failed to create directory "s + directory_.string());
+		}
+
+		// Имя файла известно только после записи, поэтому документ записывается во временный файл,
+		// который затем переименовывается. Переименование заменяет файл с тем же содержимым
+		const auto temp_path = directory_ / (".map-"s + std::to_string(std::random_device{}()) + ".tmp"s);
+		std::ofstream file(temp_path, std::ios::binary);
+		HashingBuffer buffer(*file.rdbuf());
+		std::ostream output(&buffer);
+		document.Render(output, double_format_);
+		output.flush();
+		file.close();
+		if (!output || !file) {
+			std::filesystem::remove(temp_path, error);
+			throw std::runtime_error("Failed to write map file "s + temp_path.string());
+		}
+
+		MapFile result;
+		result.hash = ToHex(buffer.Hash());
+		result.size = buffer.Size();
+		const auto path = directory_ / (result.hash + ".svg"s);
+		std::filesystem::rename(temp_path, path, error);
+		if (error) {
+			std::filesystem::remove(temp_path, error);
+			throw std::runtime_error("Failed to write map file "s + path.string());
+		}
+		result.path = path.string();
+		return result;
+	}
+
+} // namespace io
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "number_format.h"
+#include "svg.h"
+
+namespace io {
+
+	// Файл с картой, сохранённый MapStore
+	struct MapFile {
+		std::string path;
+		std::uint64_t size = 0;
+		// 64-битный хеш FNV-1a содержимого файла: 16 шестнадцатеричных цифр
+		std::string hash;
+	};
+
+	/*
+	 * Сохраняет карты в каталог в файлы с именами вида <hash>.svg, поэтому одинаковые карты
+	 * занимают один файл, в том числе при повторных запусках. Документ записывается в файл
+	 * по мере рендеринга, хеш вычисляется при записи. Каталог создаётся при первом сохранении.
+	 * При ошибке записи выбрасывается std::runtime_error
+	 */
+	class MapStore {
+	public:
+		MapStore(std::filesystem::path directory, util::DoubleFormat double_format);
+
+		MapFile Save(const svg::Document& document) const;
+
+	private:
+		std::filesystem::path directory_;
+		util::DoubleFormat double_format_;
+	};
+
+} // namespace io
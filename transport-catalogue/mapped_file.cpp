@@ -0,0 +1,73 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+
+namespace util {
+
+#if defined(_WIN32)
+
+	MappedFile::MappedFile(const std::string& path) {
+		std::ifstream input(path, std::ios::binary);
+		if (!input) {
+			throw std::system_error(errno, std::generic_category(), "Failed to open "s + path);
+		}
+		buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+		data_ = buffer_.data();
+		size_ = buffer_.size();
+	}
+
+	MappedFile::~MappedFile() = default;
+
+#else
+
+	MappedFile::MappedFile(const std::string& path) {
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "Failed to open "s + path);
+		}
+
+		struct stat info {};
+		if (fstat(fd, &info) != 0) {
+			const int error = errno;
+			close(fd);
+			throw std::system_error(error, std::generic_category(), "Failed to open "s + path);
+		}
+
+		// Пустой файл отобразить нельзя, ему соответствует пустая строка
+		size_ = static_cast<size_t>(info.st_size);
+		if (size_ > 0) {
+			void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				const int error = errno;
+				close(fd);
+				throw std::system_error(error, std::generic_category(), "Failed to map "s + path);
+			}
+			madvise(data, size_, MADV_SEQUENTIAL);
+			data_ = static_cast<const char*>(data);
+		}
+		// Отображение остаётся действительным после закрытия файла
+		close(fd);
+	}
+
+	MappedFile::~MappedFile() {
+		if (data_ != nullptr) {
+			munmap(const_cast<char*>(data_), size_);
+		}
+	}
+
+#endif
+
+} // namespace util
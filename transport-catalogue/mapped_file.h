@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+	/*
+	 * Файл, отображённый в память только для чтения, с указанием ядру читать его последовательно.
+	 * Там, где mmap недоступен, файл читается в память целиком.
+	 * Если файл не удалось открыть или отобразить, выбрасывается std::system_error
+	 */
+	class MappedFile {
+	public:
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Содержимое файла, действительное до разрушения объекта
+		std::string_view Data() const {
+			return { data_, size_ };
+		}
+
+	private:
+		const char* data_ = nullptr;
+		size_t size_ = 0;
+#if defined(_WIN32)
+		std::string buffer_;
+#endif
+	};
+
+} // namespace util
@@ -0,0 +1,202 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace util {
+
+	namespace {
+
+		// Среднее число названий в корзине. Чем больше, тем меньше места занимают группы, но дольше
+		// подбор сдвигов и тем меньше бит фильтра приходится на название (при 3 - около 10.7)
+		constexpr size_t BUCKET_LOAD = 3;
+		// Число бит фильтра, устанавливаемых для названия. Номера бит берутся по 8 из старших бит хеша фильтра
+		constexpr size_t FILTER_HASHES = 3;
+		// Если сдвиг корзины не удалось подобрать за столько попыток, индекс строится с другой солью
+		constexpr uint32_t MAX_DISPLACEMENT = 1u << 24;
+		// Число солей, которые перебираются при построении. Неудача со всеми означает, что названия
+		// повторяются или хеш-функция непригодна для набора, и перебор дальше не поможет
+		constexpr uint64_t MAX_SALTS = 64;
+
+		uint64_t Mix(uint64_t x) {
+			x ^= x >> 32;
+			x *= 0xd6e8feb86659fd93ull;
+			x ^= x >> 32;
+			x *= 0xd6e8feb86659fd93ull;
+			x ^= x >> 32;
+			return x;
+		}
+
+		// Номер i-го бита названия в фильтре группы из 256 бит
+		size_t FilterBit(uint64_t hash, size_t i) {
+			const uint64_t filter_hash = (hash ^ 0xc2b2ae3d27d4eb4full) * 0x165667b19e3779f9ull;
+			return static_cast<size_t>(filter_hash >> (56 - i * 8)) & 255;
+		}
+
+		// Отображает 32-битное значение на диапазон [0, size) без деления
+		size_t Reduce(uint32_t value, size_t size) {
+			return static_cast<size_t>((uint64_t{ value } * size) >> 32);
+		}
+
+	} // namespace
+
+	NameIndex::NameIndex(const std::vector<std::pair<std::string_view, Id>>& names) {
+		while (!Build(names)) {
+			if (++salt_ == MAX_SALTS) {
+				throw std::logic_error("Failed to build name index");
+			}
+		}
+	}
+
+	std::optional<NameIndex::Id> NameIndex::Find(std::string_view name) const {
+		if (slots_.empty()) {
+			return std::nullopt;
+		}
+		const uint64_t hash = Hash(name);
+		const size_t bucket = Bucket(hash);
+		const Group& group = groups_[bucket / GROUP_BUCKETS];
+		for (size_t i = 0; i < FILTER_HASHES; ++i) {
+			const size_t bit = FilterBit(hash, i);
+			if ((group.filter[bit / 64] >> (bit % 64) & 1) == 0) {
+				return std::nullopt;
+			}
+		}
+
+		const Slot& slot = slots_[SlotIndex(hash, group.displacements[bucket % GROUP_BUCKETS])];
+		if (slot.fingerprint != static_cast<uint32_t>(hash >> 32)) {
+			return std::nullopt;
+		}
+		return slot.id;
+	}
+
+	size_t NameIndex::MemoryUsage() const {
+		return groups_.capacity() * sizeof(Group) + slots_.capacity() * sizeof(Slot);
+	}
+
+	// Хеширует название по 8 байт, начиная с соли. Последние 8 байт читаются одним словом,
+	// перекрывая предыдущее, а более короткие названия - побайтно
+	uint64_t NameIndex::Hash(std::string_view name) const {
+		uint64_t hash = salt_ ^ (name.size() * 0x9e3779b97f4a7c15ull);
+		uint64_t word = 0;
+		if (name.size() >= 8) {
+			for (size_t pos = 0; pos + 8 < name.size(); pos += 8) {
+				std::memcpy(&word, name.data() + pos, 8);
+				hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+				hash ^= hash >> 29;
+			}
+			std::memcpy(&word, name.data() + name.size() - 8, 8);
+		}
+		else {
+			for (size_t pos = 0; pos < name.size(); ++pos) {
+				word |= uint64_t{ static_cast<unsigned char>(name[pos]) } << (pos * 8);
+			}
+		}
+		return Mix(hash ^ word);
+	}
+
+	size_t NameIndex::BucketCount() const {
+		return groups_.size() * GROUP_BUCKETS;
+	}
+
+	// Младшие 32 бита хеша выбирают корзину, старшие служат отпечатком
+	size_t NameIndex::Bucket(uint64_t hash) const {
+		return Reduce(static_cast<uint32_t>(hash), BucketCount());
+	}
+
+	size_t NameIndex::SlotIndex(uint64_t hash, uint32_t displacement) const {
+		const uint64_t slot_hash = (hash ^ (displacement * 0x9e3779b97f4a7c15ull)) * 0xc4ceb9fe1a85ec53ull;
+		return Reduce(static_cast<uint32_t>(slot_hash >> 32), slots_.size());
+	}
+
+	// Подбирает сдвиги корзин, начиная с самых больших, пока ячейки свободны. Возвращает false,
+	// если для какой-то корзины сдвиг не найден и нужна другая соль
+	bool NameIndex::Build(const std::vector<std::pair<std::string_view, Id>>& names) {
+		const size_t count = names.size();
+		const size_t bucket_count = count / BUCKET_LOAD + 1;
+		groups_.assign((bucket_count + GROUP_BUCKETS - 1) / GROUP_BUCKETS, Group{});
+		slots_.assign(count, Slot{ 0, 0 });
+		if (count == 0) {
+			return true;
+		}
+
+		std::vector<uint64_t> hashes(count);
+		std::vector<uint32_t> bucket_begin(BucketCount() + 1, 0);
+		for (size_t i = 0; i < count; ++i) {
+			hashes[i] = Hash(names[i].first);
+			++bucket_begin[Bucket(hashes[i]) + 1];
+		}
+		for (size_t bucket = 0; bucket < BucketCount(); ++bucket) {
+			bucket_begin[bucket + 1] += bucket_begin[bucket];
+		}
+		// Номера названий, сгруппированные по корзинам
+		std::vector<uint32_t> bucket_names(count);
+		{
+			std::vector<uint32_t> fill(bucket_begin.begin(), bucket_begin.end() - 1);
+			for (size_t i = 0; i < count; ++i) {
+				bucket_names[fill[Bucket(hashes[i])]++] = static_cast<uint32_t>(i);
+			}
+		}
+
+		std::vector<uint32_t> buckets(BucketCount());
+		for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+			buckets[bucket] = static_cast<uint32_t>(bucket);
+		}
+		std::stable_sort(buckets.begin(), buckets.end(), [&](uint32_t lhs, uint32_t rhs) {
+			return bucket_begin[lhs + 1] - bucket_begin[lhs] > bucket_begin[rhs + 1] - bucket_begin[rhs];
+		});
+
+		std::vector<bool> taken(count, false);
+		std::vector<size_t> positions;
+		for (const uint32_t bucket : buckets) {
+			const uint32_t begin = bucket_begin[bucket];
+			const uint32_t end = bucket_begin[bucket + 1];
+			if (begin == end) {
+				break;
+			}
+
+			// Названия с одинаковым хешем не разделит никакой сдвиг
+			for (uint32_t i = begin; i < end; ++i) {
+				for (uint32_t j = i + 1; j < end; ++j) {
+					if (hashes[bucket_names[i]] == hashes[bucket_names[j]]) {
+						return false;
+					}
+				}
+			}
+
+			bool placed = false;
+			uint32_t displacement = 0;
+			for (; displacement < MAX_DISPLACEMENT; ++displacement) {
+				positions.clear();
+				placed = true;
+				for (uint32_t i = begin; i < end && placed; ++i) {
+					const size_t position = SlotIndex(hashes[bucket_names[i]], displacement);
+					placed = !taken[position] && std::find(positions.begin(), positions.end(), position) == positions.end();
+					positions.push_back(position);
+				}
+				if (placed) {
+					break;
+				}
+			}
+			if (!placed) {
+				return false;
+			}
+
+			Group& group = groups_[bucket / GROUP_BUCKETS];
+			group.displacements[bucket % GROUP_BUCKETS] = displacement;
+			for (uint32_t i = begin; i < end; ++i) {
+				const uint32_t name = bucket_names[i];
+				const uint64_t hash = hashes[name];
+				const size_t position = positions[i - begin];
+				taken[position] = true;
+				slots_[position] = Slot{ names[name].second, static_cast<uint32_t>(hash >> 32) };
+				for (size_t j = 0; j < FILTER_HASHES; ++j) {
+					const size_t bit = FilterBit(hash, j);
+					group.filter[bit / 64] |= uint64_t{ 1 } << (bit % 64);
+				}
+			}
+		}
+		return true;
+	}
+
+} // namespace util
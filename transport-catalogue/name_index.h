@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+	/*
+	 * Неизменяемый индекс названий на основе минимальной совершенной хеш-функции: каждому из n названий
+	 * соответствует своя ячейка из n, где хранятся идентификатор и 32-битный отпечаток хеша названия.
+	 * Ячейка выбирается по хешу названия и подобранному при построении сдвигу его корзины. Сдвиги
+	 * соседних корзин хранятся в одной кэш-линии вместе с фильтром Блума названий этих корзин,
+	 * поэтому поиск отсутствующего названия обычно читает одну кэш-линию, а найденного - две
+	 */
+	class NameIndex {
+	public:
+		using Id = uint32_t;
+
+		NameIndex() = default;
+		// Названия не должны повторяться. Если индекс не удаётся построить, выбрасывает std::logic_error
+		explicit NameIndex(const std::vector<std::pair<std::string_view, Id>>& names);
+
+		// Возвращает идентификатор названия, если оно могло быть в индексе. Отсутствующее название
+		// изредка проходит фильтр и отпечаток, поэтому вызывающий сверяет название по идентификатору
+		std::optional<Id> Find(std::string_view name) const;
+
+		// Объём памяти, занятой индексом, в байтах
+		size_t MemoryUsage() const;
+
+	private:
+		struct Slot {
+			Id id;
+			uint32_t fingerprint;
+		};
+
+		static constexpr size_t GROUP_BUCKETS = 8;
+
+		// Группа корзин: фильтр Блума их названий и сдвиги
+		struct alignas(64) Group {
+			uint64_t filter[4];
+			uint32_t displacements[GROUP_BUCKETS];
+		};
+
+		// Соль хеша, при которой удалось подобрать сдвиги всех корзин
+		uint64_t salt_ = 0;
+		std::vector<Group> groups_;
+		std::vector<Slot> slots_;
+
+		uint64_t Hash(std::string_view name) const;
+		size_t BucketCount() const;
+		size_t Bucket(uint64_t hash) const;
+		size_t SlotIndex(uint64_t hash, uint32_t displacement) const;
+		bool Build(const std::vector<std::pair<std::string_view, Id>>& names);
+	};
+
+} // namespace util
@@ -0,0 +1,30 @@
+#include "number_format.h"
+
+#include <charconv>
+
+namespace util {
+
+	char* FormatNumber(char* buffer, double value, DoubleFormat format) {
+		char* const last = buffer + MAX_NUMBER_LENGTH;
+		if (format == DoubleFormat::SHORTEST) {
+			return std::to_chars(buffer, last, value).ptr;
+		}
+		// Совпадает с выводом printf("%g"), которым пользуется поток
+		return std::to_chars(buffer, last, value, std::chars_format::general, 6).ptr;
+	}
+
+	char* FormatNumber(char* buffer, std::int64_t value) {
+		return std::to_chars(buffer, buffer + MAX_NUMBER_LENGTH, value).ptr;
+	}
+
+	void WriteNumber(std::ostream& out, double value, DoubleFormat format) {
+		char buffer[MAX_NUMBER_LENGTH];
+		out.write(buffer, FormatNumber(buffer, value, format) - buffer);
+	}
+
+	void WriteNumber(std::ostream& out, std::int64_t value) {
+		char buffer[MAX_NUMBER_LENGTH];
+		out.write(buffer, FormatNumber(buffer, value) - buffer);
+	}
+
+} // namespace util
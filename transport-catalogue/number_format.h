@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace util {
+
+	// Способ записи чисел с плавающей точкой
+	enum class DoubleFormat {
+		// Как при выводе в поток с настройками по умолчанию: 6 значащих цифр (%g)
+		GENERAL,
+		// Кратчайшая запись, по которой число восстанавливается без потерь
+		SHORTEST
+	};
+
+	// Размер буфера, достаточный для записи любого числа
+	inline constexpr size_t MAX_NUMBER_LENGTH = 32;
+
+	// Записывают число в буфер размера MAX_NUMBER_LENGTH и возвращают указатель на конец записи.
+	// Запись не зависит от локали
+	char* FormatNumber(char* buffer, double value, DoubleFormat format = DoubleFormat::GENERAL);
+	char* FormatNumber(char* buffer, std::int64_t value);
+
+	// Записывают число в поток, не учитывая локаль и настройки потока
+	void WriteNumber(std::ostream& out, double value, DoubleFormat format = DoubleFormat::GENERAL);
+	void WriteNumber(std::ostream& out, std::int64_t value);
+
+} // namespace util
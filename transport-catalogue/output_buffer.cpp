@@ -0,0 +1,145 @@
+#include "output_buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+	namespace {
+
+		struct Block {
+			const char* data;
+			size_t size;
+		};
+
+		// Записывает блоки целиком, повторяя вызов после частичной записи или прерывания сигналом
+		bool WriteBlocks(int fd, Block* blocks, size_t count) {
+#if defined(_WIN32)
+			for (size_t i = 0; i < count; ++i) {
+				while (blocks[i].size > 0) {
+					const int written = _write(fd, blocks[i].data, static_cast<unsigned>(blocks[i].size));
+					if (written < 0) {
+						return false;
+					}
+					blocks[i].data += written;
+					blocks[i].size -= written;
+				}
+			}
+			return true;
+#else
+			iovec iov[64];
+			size_t first = 0;
+			while (first < count) {
+				const size_t iov_count = std::min(count - first, std::size(iov));
+				for (size_t i = 0; i < iov_count; ++i) {
+					iov[i].iov_base = const_cast<char*>(blocks[first + i].data);
+					iov[i].iov_len = blocks[first + i].size;
+				}
+
+				ssize_t written = writev(fd, iov, static_cast<int>(iov_count));
+				if (written < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					return false;
+				}
+
+				// Пропускаем записанные блоки и записанную часть следующего блока
+				while (first < count && static_cast<size_t>(written) >= blocks[first].size) {
+					written -= blocks[first].size;
+					++first;
+				}
+				if (first < count) {
+					blocks[first].data += written;
+					blocks[first].size -= written;
+				}
+			}
+			return true;
+#endif
+		}
+
+	} // namespace
+
+	FdOutputBuffer::FdOutputBuffer(int fd)
+		: fd_(fd) {
+		chunks_.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+		SetChunk(0);
+	}
+
+	FdOutputBuffer::~FdOutputBuffer() {
+		Flush();
+	}
+
+	FdOutputBuffer::int_type FdOutputBuffer::overflow(int_type c) {
+		if (traits_type::eq_int_type(c, traits_type::eof())) {
+			return traits_type::not_eof(c);
+		}
+		if (pptr() == epptr() && !NextChunk()) {
+			return traits_type::eof();
+		}
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+		return c;
+	}
+
+	std::streamsize FdOutputBuffer::xsputn(const char* s, std::streamsize count) {
+		std::streamsize written = 0;
+		while (written < count) {
+			if (pptr() == epptr() && !NextChunk()) {
+				break;
+			}
+			const auto size = std::min<std::streamsize>(count - written, epptr() - pptr());
+			std::memcpy(pptr(), s + written, size);
+			pbump(static_cast<int>(size));
+			written += size;
+		}
+		return written;
+	}
+
+	int FdOutputBuffer::sync() {
+		return Flush() ? 0 : -1;
+	}
+
+	bool FdOutputBuffer::NextChunk() {
+		if (current_ + 1 == MAX_CHUNKS) {
+			return Flush();
+		}
+		if (++current_ == chunks_.size()) {
+			chunks_.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+		}
+		SetChunk(current_);
+		return true;
+	}
+
+	bool FdOutputBuffer::Flush() {
+		if (current_ == 0 && pptr() == pbase()) {
+			return true;
+		}
+
+		Block blocks[MAX_CHUNKS];
+		for (size_t i = 0; i < current_; ++i) {
+			blocks[i] = { chunks_[i].get(), CHUNK_SIZE };
+		}
+		blocks[current_] = { pbase(), static_cast<size_t>(pptr() - pbase()) };
+
+		const bool success = WriteBlocks(fd_, blocks, current_ + 1);
+		current_ = 0;
+		SetChunk(0);
+		return success;
+	}
+
+	void FdOutputBuffer::SetChunk(size_t index) {
+		char* const chunk = chunks_[index].get();
+		setp(chunk, chunk + CHUNK_SIZE);
+	}
+
+} // namespace util
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace util {
+
+	/*
+	 * Буфер потока вывода в файловый дескриптор. Данные накапливаются в блоках по CHUNK_SIZE байт
+	 * и записываются одним вызовом writev, когда заполнены все MAX_CHUNKS блоков, а также при сбросе
+	 * потока и в деструкторе. Блоки выделяются по мере необходимости и затем переиспользуются.
+	 * При ошибке записи поток, использующий буфер, переходит в состояние badbit
+	 */
+	class FdOutputBuffer : public std::streambuf {
+	public:
+		explicit FdOutputBuffer(int fd);
+		~FdOutputBuffer() override;
+
+		FdOutputBuffer(const FdOutputBuffer&) = delete;
+		FdOutputBuffer& operator=(const FdOutputBuffer&) = delete;
+
+	protected:
+		int_type overflow(int_type c) override;
+		std::streamsize xsputn(const char* s, std::streamsize count) override;
+		int sync() override;
+
+	private:
+		static constexpr size_t CHUNK_SIZE = 1 << 20;
+		static constexpr size_t MAX_CHUNKS = 16;
+
+		int fd_;
+		std::vector<std::unique_ptr<char[]>> chunks_;
+		// Номер заполняемого блока; предыдущие блоки заполнены целиком
+		size_t current_ = 0;
+
+		// Переходит к следующему блоку, записывая накопленные данные, если свободных блоков нет
+		bool NextChunk();
+		bool Flush();
+		void SetChunk(size_t index);
+	};
+
+} // namespace util
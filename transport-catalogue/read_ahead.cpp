@@ -0,0 +1,146 @@
+#include "read_ahead.h"
+
+#include <cerrno>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+	ReadAheadReader::ReadAheadReader(std::istream& input)
+		: input_(input)
+		, blocks_(BLOCK_COUNT) {
+#if !defined(_WIN32)
+		// Из std::cin до этого ничего не читалось, поэтому его буфер пуст и дескриптор можно читать напрямую
+		if (&input_ == &std::cin && ::pipe(wake_) == 0) {
+			fd_ = STDIN_FILENO;
+		}
+#endif
+		thread_ = std::thread([this] {
+			Read();
+		});
+	}
+
+	ReadAheadReader::~ReadAheadReader() {
+		{
+			std::lock_guard lock(mutex_);
+			cancelled_ = true;
+		}
+		changed_.notify_all();
+#if !defined(_WIN32)
+		if (fd_ >= 0) {
+			const char byte = 0;
+			while (::write(wake_[1], &byte, 1) < 0 && errno == EINTR) {
+			}
+		}
+#endif
+		thread_.join();
+#if !defined(_WIN32)
+		if (fd_ >= 0) {
+			::close(wake_[0]);
+			::close(wake_[1]);
+		}
+#endif
+	}
+
+	std::string_view ReadAheadReader::Next() {
+		std::unique_lock lock(mutex_);
+		if (holding_) {
+			++consumed_;
+			holding_ = false;
+			changed_.notify_all();
+		}
+
+		if (consumed_ == filled_ && !finished_) {
+			const auto start = std::chrono::steady_clock::now();
+			changed_.wait(lock, [this] {
+				return consumed_ != filled_ || finished_;
+			});
+			wait_time_ += std::chrono::steady_clock::now() - start;
+		}
+		if (consumed_ == filled_) {
+			return {};
+		}
+
+		holding_ = true;
+		const auto& block = blocks_[consumed_ % BLOCK_COUNT];
+		return { block.data.get(), block.size };
+	}
+
+	// Заполняет свободные блоки, пока поток не закончится. Блок, занятый получателем, не перезаписывается
+	void ReadAheadReader::Read() {
+		while (true) {
+			size_t index = 0;
+			{
+				std::unique_lock lock(mutex_);
+				changed_.wait(lock, [this] {
+					return filled_ - consumed_ < BLOCK_COUNT || cancelled_;
+				});
+				if (cancelled_) {
+					return;
+				}
+				index = filled_ % BLOCK_COUNT;
+			}
+
+			auto& block = blocks_[index];
+			const bool more = Fill(block);
+
+			{
+				std::lock_guard lock(mutex_);
+				if (cancelled_) {
+					return;
+				}
+				if (block.size > 0) {
+					++filled_;
+				}
+				finished_ = !more;
+			}
+			changed_.notify_all();
+			if (!more) {
+				return;
+			}
+		}
+	}
+
+	bool ReadAheadReader::Fill(Block& block) {
+		if (fd_ >= 0) {
+			return FillFromDescriptor(block);
+		}
+		input_.read(block.data.get(), BLOCK_SIZE);
+		block.size = static_cast<size_t>(input_.gcount());
+		return static_cast<bool>(input_);
+	}
+
+	// Ошибка чтения, как и для std::istream, завершает поток. При отмене возвращает false
+	bool ReadAheadReader::FillFromDescriptor(Block& block) {
+		block.size = 0;
+#if !defined(_WIN32)
+		while (block.size < BLOCK_SIZE) {
+			pollfd fds[2] = { { fd_, POLLIN, 0 }, { wake_[0], POLLIN, 0 } };
+			if (::poll(fds, 2, -1) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			if (fds[1].revents != 0) {
+				return false;
+			}
+
+			const ssize_t read = ::read(fd_, block.data.get() + block.size, BLOCK_SIZE - block.size);
+			if (read > 0) {
+				block.size += static_cast<size_t>(read);
+			} else if (read == 0 || (errno != EINTR && errno != EAGAIN)) {
+				return false;
+			}
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+} // namespace util
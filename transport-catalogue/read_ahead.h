@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+	/*
+	 * Читает поток в отдельном потоке выполнения в кольцо из BLOCK_COUNT блоков по BLOCK_SIZE байт,
+	 * пока получатель обрабатывает уже прочитанные блоки. Поток input используется только
+	 * потоком чтения до разрушения объекта.
+	 * Деструктор отменяет чтение, не дожидаясь получателя. Стандартный ввод читается напрямую
+	 * из дескриптора, чтобы отмена прерывала и ожидание данных из канала, который не закрыт
+	 */
+	class ReadAheadReader {
+	public:
+		explicit ReadAheadReader(std::istream& input);
+		~ReadAheadReader();
+
+		ReadAheadReader(const ReadAheadReader&) = delete;
+		ReadAheadReader& operator=(const ReadAheadReader&) = delete;
+
+		// Возвращает очередной прочитанный блок или пустую строку в конце потока. Блок остаётся
+		// действительным до следующего вызова, после которого возвращается в кольцо для чтения
+		std::string_view Next();
+
+		// Суммарное время, в течение которого Next ожидал чтения блока
+		std::chrono::nanoseconds WaitTime() const {
+			return wait_time_;
+		}
+
+	private:
+		static constexpr size_t BLOCK_SIZE = 1 << 20;
+		static constexpr size_t BLOCK_COUNT = 8;
+
+		struct Block {
+			std::unique_ptr<char[]> data{ new char[BLOCK_SIZE] };
+			size_t size = 0;
+		};
+
+		std::istream& input_;
+		std::vector<Block> blocks_;
+
+		std::mutex mutex_;
+		std::condition_variable changed_;
+		// Блоки с номерами [consumed_, filled_) прочитаны и ожидают получателя, номера считаются по модулю BLOCK_COUNT
+		size_t filled_ = 0;
+		size_t consumed_ = 0;
+		bool finished_ = false;
+		// Чтение отменено деструктором
+		bool cancelled_ = false;
+		// Блок, возвращённый последним вызовом Next
+		bool holding_ = false;
+
+		// Дескриптор стандартного ввода и канал, запись в который будит поток чтения при отмене.
+		// Для остальных потоков fd_ равен -1
+		int fd_ = -1;
+		int wake_[2] = { -1, -1 };
+
+		std::chrono::nanoseconds wait_time_{ 0 };
+		std::thread thread_;
+
+		void Read();
+		// Заполняет блок целиком или до конца потока. Возвращает false, если поток закончился
+		bool Fill(Block& block);
+		bool FillFromDescriptor(Block& block);
+	};
+
+} // namespace util
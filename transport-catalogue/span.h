@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace util {
+
+	// Непрерывный диапазон элементов, которыми владеет другой объект
+	template <typename T>
+	class Span {
+	public:
+		Span() = default;
+		Span(T* data, size_t size)
+			: data_(data)
+			, size_(size) {
+		}
+
+		T* begin() const {
+			return data_;
+		}
+
+		T* end() const {
+			return data_ + size_;
+		}
+
+		T& operator[](size_t index) const {
+			return data_[index];
+		}
+
+		size_t size() const {
+			return size_;
+		}
+
+		bool empty() const {
+			return size_ == 0;
+		}
+
+	private:
+		T* data_ = nullptr;
+		size_t size_ = 0;
+	};
+
+} // namespace util
@@ -0,0 +1,41 @@
+#include "string_pool.h"
+
+namespace util {
+
+	StringPool::Id StringPool::Intern(std::string_view str) {
+		if (const auto it = ids_.find(str); it != ids_.end()) {
+			return it->second;
+		}
+		const Id id = static_cast<Id>(strings_.size());
+		// Ключ словаря ссылается на экземпляр строки в пуле, а не на аргумент
+		ids_.emplace(strings_.emplace_back(str), id);
+		return id;
+	}
+
+	std::optional<StringPool::Id> StringPool::Find(std::string_view str) const {
+		if (const auto it = ids_.find(str); it != ids_.end()) {
+			return it->second;
+		}
+		return std::nullopt;
+	}
+
+	std::string_view StringPool::Get(Id id) const {
+		return strings_[id];
+	}
+
+	size_t StringPool::Size() const {
+		return strings_.size();
+	}
+
+	void StringPool::ReleaseIndex() {
+		ids_ = {};
+	}
+
+	void StringPool::RestoreIndex() {
+		ids_.reserve(strings_.size());
+		for (Id id = 0; id < strings_.size(); ++id) {
+			ids_.emplace(strings_[id], id);
+		}
+	}
+
+} // namespace util
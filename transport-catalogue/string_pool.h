@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace util {
+
+	// Хранит по одному экземпляру каждой добавленной строки и выдаёт строкам последовательные
+	// идентификаторы, начиная с нуля. Строки не перемещаются, пока существует пул
+	class StringPool {
+	public:
+		using Id = uint32_t;
+
+		// Возвращает идентификатор строки, добавляя её в пул, если её там ещё нет
+		Id Intern(std::string_view str);
+		std::optional<Id> Find(std::string_view str) const;
+		std::string_view Get(Id id) const;
+
+		size_t Size() const;
+
+		// Освобождает словарь строк, оставляя сами строки: до вызова RestoreIndex
+		// можно пользоваться только Get и Size
+		void ReleaseIndex();
+		// Восстанавливает словарь строк после ReleaseIndex
+		void RestoreIndex();
+
+	private:
+		std::deque<std::string> strings_;
+		std::unordered_map<std::string_view, Id> ids_;
+	};
+
+} // namespace util
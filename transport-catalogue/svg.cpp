@@ -19,14 +19,15 @@ namespace svg {
         : out(out) {
     }
 
-    RenderContext::RenderContext(std::ostream& out, int indent_step, int indent)
+    RenderContext::RenderContext(std::ostream& out, int indent_step, int indent, util::DoubleFormat double_format)
         : out(out)
         , indent_step(indent_step)
-        , indent(indent) {
+        , indent(indent)
+        , double_format(double_format) {
     }
 
     RenderContext RenderContext::Indented() const {
-        return { out, indent_step, indent + indent_step };
+        return { out, indent_step, indent + indent_step, double_format };
     }
 
     void RenderContext::RenderIndent() const {
@@ -35,6 +36,10 @@ namespace svg {
         }
     }
 
+    void RenderContext::RenderNumber(double value) const {
+        util::WriteNumber(out, value, double_format);
+    }
+
     // ---------- Object ------------------
 
     void Object::Render(const RenderContext& context) const {
@@ -43,7 +48,7 @@ namespace svg {
         // Делегируем вывод тега своим подклассам
         RenderObject(context);
 
-        context.out << std::endl;
+        context.out << '\n';
     }
 
     // ---------- Color ------------------
@@ -63,6 +68,7 @@ namespace svg {
 
     struct ColorPrinter {
         std::ostream& out;
+        util::DoubleFormat double_format;
 
         void operator()(std::monostate) const {
             out << "none"sv;
@@ -84,18 +90,23 @@ namespace svg {
             out << "rgba("sv
                 << static_cast<int>(color.red) << ','
                 << static_cast<int>(color.green) << ','
-                << static_cast<int>(color.blue) << ','
-                << color.opacity
-                << ')';
+                << static_cast<int>(color.blue) << ',';
+            util::WriteNumber(out, color.opacity, double_format);
+            out << ')';
         }
     };
 
     std::ostream& operator<<(std::ostream& out, const Color& color) {
-        ColorPrinter printer{ out };
+        ColorPrinter printer{ out, util::DoubleFormat::GENERAL };
         std::visit(printer, color);
         return out;
     }
 
+    void RenderColor(const RenderContext& context, const Color& color) {
+        ColorPrinter printer{ context.out, context.double_format };
+        std::visit(printer, color);
+    }
+
     // ---------- Enums ------------------
 
     std::ostream& operator<<(std::ostream& out, StrokeLineCap linecap) {
@@ -163,10 +174,14 @@ namespace svg {
     void Circle::RenderObject(const RenderContext& context) const {
         auto& out = context.out;
         out << "<circle"sv;
-        out << " cx=\""sv << center_.x << "\""sv;
-        out << " cy=\""sv << center_.y << "\""sv;
-        out << " r=\""sv << radius_ << "\""sv;
-        RenderAttrs(out);
+        out << " cx=\""sv;
+        context.RenderNumber(center_.x);
+        out << "\" cy=\""sv;
+        context.RenderNumber(center_.y);
+        out << "\" r=\""sv;
+        context.RenderNumber(radius_);
+        out << "\""sv;
+        RenderAttrs(context);
         out << "/>"sv;
     }
 
@@ -185,11 +200,13 @@ namespace svg {
             if (!first) {
                 out << ' ';
             }
-            out << point.x << ',' << point.y;
+            context.RenderNumber(point.x);
+            out << ',';
+            context.RenderNumber(point.y);
             first = false;
         }
         out << "\""sv;
-        RenderAttrs(out);
+        RenderAttrs(context);
         out << "/>"sv;
     }
 
@@ -229,10 +246,15 @@ namespace svg {
         auto& out = context.out;
 
         out << "<text"sv;
-        out << " x=\""sv << pos_.x << "\""sv;
-        out << " y=\""sv << pos_.y << "\""sv;
-        out << " dx=\""sv << offset_.x << "\""sv;
-        out << " dy=\""sv << offset_.y << "\""sv;
+        out << " x=\""sv;
+        context.RenderNumber(pos_.x);
+        out << "\" y=\""sv;
+        context.RenderNumber(pos_.y);
+        out << "\" dx=\""sv;
+        context.RenderNumber(offset_.x);
+        out << "\" dy=\""sv;
+        context.RenderNumber(offset_.y);
+        out << "\""sv;
         out << " font-size=\""sv << size_ << "\""sv;
         if (font_family_) {
             out << " font-family=\""sv << *font_family_ << "\""sv;
@@ -240,7 +262,7 @@ namespace svg {
         if (font_weight_) {
             out << " font-weight=\""sv << *font_weight_ << "\""sv;
         }
-        RenderAttrs(out);
+        RenderAttrs(context);
         out << ">";
 
         out << EscapedString(data_);
@@ -280,11 +302,11 @@ namespace svg {
         objects_.push_back(std::move(obj));
     }
 
-    void Document::Render(std::ostream& out) const {
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+    void Document::Render(std::ostream& out, util::DoubleFormat double_format) const {
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
 
-        RenderContext context(out, 2, 2);
+        RenderContext context(out, 2, 2, double_format);
         for (const auto& obj : objects_) {
             obj->Render(context);
         }
@@ -8,6 +8,8 @@
 #include <vector>
 #include <utility>
 
+#include "number_format.h"
+
 namespace svg {
 
     struct Point {
@@ -21,19 +23,23 @@ namespace svg {
     /*
      * Вспомогательная структура, хранящая контекст для вывода SVG-документа с отступами.
      * Хранит ссылку на поток вывода, текущее значение и шаг отступа при выводе элемента
+     * и способ записи чисел
      */
     struct RenderContext {
         RenderContext(std::ostream& out);
 
-        RenderContext(std::ostream& out, int indent_step, int indent = 0);
+        RenderContext(std::ostream& out, int indent_step, int indent = 0,
+                      util::DoubleFormat double_format = util::DoubleFormat::GENERAL);
 
         RenderContext Indented() const;
 
         void RenderIndent() const;
+        void RenderNumber(double value) const;
 
         std::ostream& out;
         int indent_step = 0;
         int indent = 0;
+        util::DoubleFormat double_format = util::DoubleFormat::GENERAL;
     };
 
     /*
@@ -77,6 +83,8 @@ namespace svg {
     inline const Color NoneColor;
 
     std::ostream& operator<<(std::ostream& out, const Color& color);
+    // В отличие от вывода в поток, числа записываются способом, заданным в контексте
+    void RenderColor(const RenderContext& context, const Color& color);
 
     enum class StrokeLineCap {
         BUTT,
@@ -131,17 +139,24 @@ namespace svg {
     protected:
         ~PathProps() = default;
 
-        void RenderAttrs(std::ostream& out) const {
+        void RenderAttrs(const RenderContext& context) const {
             using namespace std::literals;
+            auto& out = context.out;
 
             if (fill_color_) {
-                out << " fill=\""sv << *fill_color_ << "\""sv;
+                out << " fill=\""sv;
+                RenderColor(context, *fill_color_);
+                out << "\""sv;
             }
             if (stroke_color_) {
-                out << " stroke=\""sv << *stroke_color_ << "\""sv;
+                out << " stroke=\""sv;
+                RenderColor(context, *stroke_color_);
+                out << "\""sv;
             }
             if (stroke_width_) {
-                out << " stroke-width=\""sv << *stroke_width_ << "\""sv;
+                out << " stroke-width=\""sv;
+                context.RenderNumber(*stroke_width_);
+                out << "\""sv;
             }
             if (stroke_linecap_) {
                 out << " stroke-linecap=\""sv << *stroke_linecap_ << "\""sv;
@@ -251,7 +266,7 @@ namespace svg {
     class Document : public ObjectContainer {
     public:
         void AddPtr(std::unique_ptr<Object>&& obj) override;
-        void Render(std::ostream& out) const;
+        void Render(std::ostream& out, util::DoubleFormat double_format = util::DoubleFormat::GENERAL) const;
 
     private:
         std::vector<std::unique_ptr<Object>> objects_;
@@ -0,0 +1,56 @@
+#include "thread_pool.h"
+
+namespace util {
+
+	ThreadPool::ThreadPool(size_t threads) {
+		workers_.reserve(threads);
+		for (size_t i = 0; i < threads; ++i) {
+			workers_.emplace_back([this] {
+				Work();
+			});
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock(mutex_);
+			stopped_ = true;
+		}
+		has_tasks_.notify_all();
+		for (auto& worker : workers_) {
+			worker.join();
+		}
+	}
+
+	size_t ThreadPool::Size() const {
+		return workers_.size();
+	}
+
+	void ThreadPool::Push(std::function<void()> task) {
+		{
+			std::lock_guard lock(mutex_);
+			tasks_.push_back(std::move(task));
+		}
+		has_tasks_.notify_one();
+	}
+
+	// Выполняет задачи, пока пул не будет остановлен и очередь не опустеет
+	void ThreadPool::Work() {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock lock(mutex_);
+				has_tasks_.wait(lock, [this] {
+					return stopped_ || !tasks_.empty();
+				});
+				if (tasks_.empty()) {
+					return;
+				}
+				task = std::move(tasks_.front());
+				tasks_.pop_front();
+			}
+			task();
+		}
+	}
+
+} // namespace util
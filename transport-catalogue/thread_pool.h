@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+	// Пул потоков фиксированного размера, выполняющий задачи в порядке их добавления
+	class ThreadPool {
+	public:
+		explicit ThreadPool(size_t threads);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t Size() const;
+
+		// Добавляет задачу в очередь. Результат задачи или выброшенное ею исключение
+		// передаются через возвращаемый future
+		template <typename Task>
+		auto Submit(Task task) -> std::future<decltype(task())>;
+
+	private:
+		std::vector<std::thread> workers_;
+		std::mutex mutex_;
+		std::condition_variable has_tasks_;
+		std::deque<std::function<void()>> tasks_;
+		bool stopped_ = false;
+
+		void Push(std::function<void()> task);
+		void Work();
+	};
+
+	template <typename Task>
+	auto ThreadPool::Submit(Task task) -> std::future<decltype(task())> {
+		// std::function требует копируемого объекта, поэтому packaged_task хранится в shared_ptr
+		auto packaged_task = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+		auto result = packaged_task->get_future();
+		Push([packaged_task] {
+			(*packaged_task)();
+		});
+		return result;
+	}
+
+} // namespace util
@@ -1,154 +1,381 @@
+#include <algorithm>
 #include <cassert>
-#include <functional>
-#include <unordered_set>
+#include <cmath>
+#include <future>
+#include <tuple>
 
 #include "transport_catalogue.h"
 
 namespace tc {
 
-	bool TransportCatalogue::SetOfBusesCmp::operator() (const Bus* lhs, const Bus* rhs) const {
-		return lhs->name < rhs->name;
+	StopId TransportCatalogue::GetStopId(std::string_view name) {
+		ResetFinalize();
+		const StopId id = stop_names_.Intern(name);
+		if (id == stop_coordinates_.size()) {
+			stop_coordinates_.emplace_back();
+			stop_added_.push_back(false);
+		}
+		return id;
 	}
 
-	size_t TransportCatalogue::StopsHasher::operator() (const std::pair<const Stop*, const Stop*>& stops) const {
-		std::hash<const Stop*> hasher;
-		return hasher(stops.first) + 37 * hasher(stops.second);
+	void TransportCatalogue::AddStop(StopId id, geo::Coordinates coordinates) {
+		ResetFinalize();
+		// При повторном добавлении остановки с тем же названием сохраняется первая из них
+		if (!stop_added_[id]) {
+			stop_coordinates_[id] = coordinates;
+			stop_added_[id] = true;
+		}
 	}
 
-	void TransportCatalogue::AddStop(std::string name, geo::Coordinates coordinates) {
-		Stop stop{ std::move(name), std::move(coordinates) };
-		stops_.push_back(std::move(stop));
-		name_to_stop_.emplace(stops_.back().name, &stops_.back());
-		stop_to_buses_.emplace(&stops_.back(), SetOfBuses());
+	void TransportCatalogue::AddDistance(StopId from, StopId to, uint32_t distance) {
+		ResetFinalize();
+		distance_edges_.push_back(DistanceEdge{ from, to, distance });
 	}
 
-	void TransportCatalogue::AddDistance(const std::string& from, const std::string& to, uint32_t distance) {
-		auto stop_from = FindStop(from);
-		auto stop_to = FindStop(to);
-		std::pair<const Stop*, const Stop*> key(stop_from, stop_to);
-		stops_to_distance_.emplace(key, distance);
+	void TransportCatalogue::AddBus(std::string name, bool ring, const std::vector<StopId>& stop_ids) {
+		assert(stop_ids.size() > 1);
+		ResetFinalize();
+		const BusId bus = static_cast<BusId>(bus_names_.size());
+
+		bus_names_.push_back(std::move(name));
+		bus_ring_.push_back(ring);
+		bus_stops_.insert(bus_stops_.end(), stop_ids.begin(), stop_ids.end());
+		bus_stops_begin_.push_back(static_cast<uint32_t>(bus_stops_.size()));
+
+		name_to_bus_.emplace(bus_names_.back(), bus);
 	}
 
-	void TransportCatalogue::AddBus(std::string name, bool ring, const std::vector<std::string>& stop_names) {
-		assert(stop_names.size() > 1);
-		Bus bus{ std::move(name), ring, {} };
+	bool TransportCatalogue::HasStop(StopId id) const {
+		return stop_added_[id];
+	}
 
-		std::vector<const Stop*> stops;
-		stops.reserve(stop_names.size());
+	void TransportCatalogue::AddStop(std::string_view name, geo::Coordinates coordinates) {
+		AddStop(GetStopId(name), coordinates);
+	}
+
+	void TransportCatalogue::AddDistance(std::string_view from, std::string_view to, uint32_t distance) {
+		AddDistance(GetStopId(from), GetStopId(to), distance);
+	}
+
+	void TransportCatalogue::AddBus(std::string name, bool ring, const std::vector<std::string>& stop_names) {
+		std::vector<StopId> stop_ids;
+		stop_ids.reserve(stop_names.size());
 		for (const auto& stop_name : stop_names) {
-			auto stop = FindStop(stop_name);
-			stops.push_back(stop);
+			stop_ids.push_back(GetStopId(stop_name));
 		}
-		bus.stops = std::move(stops);
+		AddBus(std::move(name), ring, stop_ids);
+	}
 
-		buses_.push_back(std::move(bus));
-		name_to_bus_.emplace(buses_.back().name, &buses_.back());
-		AddBusToStops(buses_.back());
+	bool TransportCatalogue::HasStop(std::string_view name) const {
+		return FindStop(name).has_value();
 	}
 
-	std::vector<const Bus*> TransportCatalogue::GetBuses() const {
-		std::vector<const Bus*> buses;
-		buses.reserve(buses_.size());
+	void TransportCatalogue::Finalize(BusInfoMode mode, util::ThreadPool* thread_pool) {
+		ResetFinalize();
+
+		std::vector<std::pair<std::string_view, util::NameIndex::Id>> names;
+		for (StopId stop = 0; stop < stop_added_.size(); ++stop) {
+			if (stop_added_[stop]) {
+				names.emplace_back(stop_names_.Get(stop), stop);
+			}
+		}
+		stop_index_ = util::NameIndex(names);
+		// Остановки ищутся по индексу, поэтому словарь пула не нужен
+		stop_names_.ReleaseIndex();
+
+		names.assign(name_to_bus_.begin(), name_to_bus_.end());
+		bus_index_ = util::NameIndex(names);
+		name_to_bus_ = {};
+		BuildStopBuses();
+		BuildDistanceRows();
+		finalized_ = true;
+
+		const size_t count = bus_names_.size();
+		bus_infos_.assign(count, BusInfo{});
 
-		for (const auto& bus : buses_) {
-			buses.push_back(&bus);
-		
+		if (mode == BusInfoMode::LAZY) {
+			bus_info_flags_ = std::make_unique<std::once_flag[]>(count);
+			return;
 		}
+		bus_info_flags_.reset();
 
-		return buses;
+		if (thread_pool == nullptr || thread_pool->Size() == 1) {
+			for (BusId bus = 0; bus < count; ++bus) {
+				bus_infos_[bus] = ComputeBusInfo(bus);
+			}
+			return;
+		}
+
+		// Маршруты делятся на участки, по несколько участков на поток
+		const size_t chunks_per_thread = 4;
+		const size_t chunk_size = count / (thread_pool->Size() * chunks_per_thread) + 1;
+		std::vector<std::future<void>> chunks;
+		for (size_t first = 0; first < count; first += chunk_size) {
+			const size_t last = std::min(first + chunk_size, count);
+			chunks.push_back(thread_pool->Submit([this, first, last] {
+				for (size_t bus = first; bus < last; ++bus) {
+					bus_infos_[bus] = ComputeBusInfo(static_cast<BusId>(bus));
+				}
+			}));
+		}
+		for (auto& chunk : chunks) {
+			chunk.get();
+		}
+	}
+
+	BusesView TransportCatalogue::GetBusesView() const {
+		BusesView view;
+
+		// Структуры Stop создаются только для остановок, через которые проходят маршруты
+		std::vector<const Stop*> stops(stop_coordinates_.size(), nullptr);
+		const auto get_stop = [&](StopId id) {
+			if (stops[id] == nullptr) {
+				stops[id] = &view.stops_.emplace_back(Stop{ std::string(stop_names_.Get(id)), stop_coordinates_[id] });
+			}
+			return stops[id];
+		};
+
+		view.bus_pointers_.reserve(bus_names_.size());
+		for (BusId bus = 0; bus < bus_names_.size(); ++bus) {
+			auto& bus_view = view.buses_.emplace_back(Bus{ bus_names_[bus], bus_ring_[bus], {} });
+			bus_view.stops.reserve(bus_stops_begin_[bus + 1] - bus_stops_begin_[bus]);
+			for (uint32_t i = bus_stops_begin_[bus]; i < bus_stops_begin_[bus + 1]; ++i) {
+				bus_view.stops.push_back(get_stop(bus_stops_[i]));
+			}
+			view.bus_pointers_.push_back(&bus_view);
+		}
+
+		return view;
 	}
 
 	std::optional<StopInfo> TransportCatalogue::GetStopInfo(const std::string& name) const {
-		auto stop = FindStop(name);
+		assert(finalized_);
+		const auto stop = FindStop(name);
 		if (!stop) {
 			return std::nullopt;
 		}
 
-		StopInfo stop_info;
+		const uint32_t begin = stop_buses_begin_[*stop];
+		return StopInfo{ { stop_bus_names_.data() + begin, stop_buses_begin_[*stop + 1] - begin } };
+	}
 
-		const auto& set_of_buses = stop_to_buses_.at(stop);
-		std::vector<std::string> buses;
-		buses.reserve(set_of_buses.size());
-		for (auto bus : set_of_buses) {
-			buses.push_back(bus->name);
+	std::optional<BusInfo> TransportCatalogue::GetBusInfo(const std::string& name) const {
+		const auto bus = FindBus(name);
+		if (!bus) {
+			return std::nullopt;
+		}
+		assert(finalized_);
+		if (bus_info_flags_) {
+			std::call_once(bus_info_flags_[*bus], [this, bus] {
+				bus_infos_[*bus] = ComputeBusInfo(*bus);
+			});
+		}
+		assert(std::isfinite(bus_infos_[*bus].curvature));
+		return bus_infos_[*bus];
+	}
+
+	std::optional<StopId> TransportCatalogue::FindStop(std::string_view name) const {
+		if (finalized_) {
+			const auto id = stop_index_.Find(name);
+			if (id && stop_names_.Get(*id) == name) {
+				return id;
+			}
+			return std::nullopt;
 		}
-		stop_info.buses = std::move(buses);
 
-		return stop_info;
+		const auto id = stop_names_.Find(name);
+		if (id && stop_added_[*id]) {
+			return id;
+		}
+		else {
+			return std::nullopt;
+		}
 	}
 
-	std::optional<BusInfo> TransportCatalogue::GetBusInfo(const std::string& name) const {
-		auto bus = FindBus(name);
-		if (!bus) {
+	std::optional<BusId> TransportCatalogue::FindBus(std::string_view name) const {
+		if (finalized_) {
+			const auto id = bus_index_.Find(name);
+			if (id && bus_names_[*id] == name) {
+				return id;
+			}
+			return std::nullopt;
+		}
+
+		const auto it = name_to_bus_.find(name);
+		if (it != name_to_bus_.end()) {
+			return it->second;
+		}
+		else {
 			return std::nullopt;
 		}
+	}
 
-		auto& stops = bus->stops;
+	BusInfo TransportCatalogue::ComputeBusInfo(BusId bus) const {
+		const StopId* stops = bus_stops_.data() + bus_stops_begin_[bus];
+		const size_t count = bus_stops_begin_[bus + 1] - bus_stops_begin_[bus];
+		const bool ring = bus_ring_[bus];
 
-		size_t stops_num = bus->ring ? stops.size() : stops.size() * 2 - 1;
-		std::unordered_set<const Stop*> unique_stops;
+		// У маршрута без остановок длина и извилистость не определены, он проверяется так же,
+		// как маршрут с совпадающими координатами остановок
+		const size_t stops_num = ring || count == 0 ? count : count * 2 - 1;
 		double fact_length = 0.0;
 		double geo_length = 0.0;
 
-		for (size_t i = 0; i < stops.size() - 1; ++i) {
+		for (size_t i = 0; i + 1 < count; ++i) {
 			fact_length += ComputeDistance(stops[i], stops[i + 1], DistanceType::FACT);
 			geo_length += ComputeDistance(stops[i], stops[i + 1], DistanceType::GEO);
-			unique_stops.insert(stops[i]);
 		}
-		unique_stops.insert(stops[stops.size() - 1]);
 
-		if (!bus->ring) {
-			for (size_t i = stops.size() - 1; i > 0; --i) {
-				fact_length += ComputeDistance(stops[i], stops[i - 1], DistanceType::FACT);
+		if (!ring) {
+			for (size_t i = count; i > 1; --i) {
+				fact_length += ComputeDistance(stops[i - 1], stops[i - 2], DistanceType::FACT);
 			}
 			geo_length *= 2.0;
 		}
 
-		assert(geo_length > 0.0);
+		std::vector<StopId> unique_stops(stops, stops + count);
+		std::sort(unique_stops.begin(), unique_stops.end());
+		const size_t unique_num = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
 
-		return BusInfo{ static_cast<int>(stops_num), static_cast<int>(unique_stops.size()), fact_length, fact_length / geo_length };
+		// У маршрута с совпадающими координатами остановок извилистость не определена и получается
+		// бесконечной или NaN. Finalize вычисляет сведения и о маршрутах, которые никто не запросит,
+		// поэтому такой маршрут проверяется только при запросе в GetBusInfo
+		return BusInfo{ static_cast<int>(stops_num), static_cast<int>(unique_num), fact_length, fact_length / geo_length };
 	}
 
-	const Stop* TransportCatalogue::FindStop(const std::string& name) const {
-		const auto it = name_to_stop_.find(name);
-		if (it != name_to_stop_.end()) {
-			return it->second;
+	void TransportCatalogue::ResetFinalize() {
+		if (!finalized_) {
+			return;
 		}
-		else {
-			return nullptr;
+		finalized_ = false;
+		stop_index_ = {};
+		bus_index_ = {};
+		stop_buses_begin_ = {};
+		stop_bus_names_ = {};
+		bus_infos_ = {};
+		bus_info_flags_.reset();
+		stop_names_.RestoreIndex();
+
+		// Словарь маршрутов восстанавливается в порядке добавления, чтобы первый маршрут с названием остался первым
+		for (BusId bus = 0; bus < bus_names_.size(); ++bus) {
+			name_to_bus_.emplace(bus_names_[bus], bus);
 		}
+		ReleaseDistanceRows();
 	}
 
-	const Bus* TransportCatalogue::FindBus(const std::string& name) const {
-		const auto it = name_to_bus_.find(name);
-		if (it != name_to_bus_.end()) {
-			return it->second;
+	double TransportCatalogue::ComputeDistance(StopId from, StopId to, DistanceType type) const {
+		if (type == DistanceType::FACT) {
+			if (auto distance = FindDistance(from, to)) {
+				return *distance;
+			}
+			if (auto distance = FindDistance(to, from)) {
+				return *distance;
+			}
 		}
-		else {
-			return nullptr;
+
+		return geo::ComputeDistance(stop_coordinates_[from], stop_coordinates_[to]);
+	}
+
+	// Маршруты сравниваются по рангу названия, поэтому названия сравниваются только при сортировке маршрутов
+	void TransportCatalogue::BuildStopBuses() {
+		std::vector<BusId> by_name(bus_names_.size());
+		for (BusId bus = 0; bus < by_name.size(); ++bus) {
+			by_name[bus] = bus;
 		}
+		std::sort(by_name.begin(), by_name.end(), [this](BusId lhs, BusId rhs) {
+			return bus_names_[lhs] < bus_names_[rhs];
+		});
+
+		// Маршруты с одинаковыми названиями получают один ранг
+		std::vector<std::string_view> names;
+		std::vector<uint32_t> ranks(bus_names_.size());
+		for (const BusId bus : by_name) {
+			if (names.empty() || names.back() != bus_names_[bus]) {
+				names.push_back(bus_names_[bus]);
+			}
+			ranks[bus] = static_cast<uint32_t>(names.size() - 1);
+		}
+
+		// Ранги маршрутов раскладываются по остановкам с повторениями, затем каждая строка
+		// упорядочивается и сжимается на месте
+		std::vector<uint32_t> begin(stop_coordinates_.size() + 1, 0);
+		for (const StopId stop : bus_stops_) {
+			++begin[stop + 1];
+		}
+		for (size_t stop = 0; stop + 1 < begin.size(); ++stop) {
+			begin[stop + 1] += begin[stop];
+		}
+		std::vector<uint32_t> stop_ranks(bus_stops_.size());
+		{
+			std::vector<uint32_t> fill(begin.begin(), begin.end() - 1);
+			for (BusId bus = 0; bus < bus_names_.size(); ++bus) {
+				for (uint32_t i = bus_stops_begin_[bus]; i < bus_stops_begin_[bus + 1]; ++i) {
+					stop_ranks[fill[bus_stops_[i]]++] = ranks[bus];
+				}
+			}
+		}
+
+		stop_buses_begin_.assign(begin.size(), 0);
+		stop_bus_names_.clear();
+		for (size_t stop = 0; stop + 1 < begin.size(); ++stop) {
+			const auto first = stop_ranks.begin() + begin[stop];
+			const auto last = stop_ranks.begin() + begin[stop + 1];
+			std::sort(first, last);
+			const auto unique_last = std::unique(first, last);
+			for (auto it = first; it != unique_last; ++it) {
+				stop_bus_names_.push_back(names[*it]);
+			}
+			stop_buses_begin_[stop + 1] = static_cast<uint32_t>(stop_bus_names_.size());
+		}
+		stop_bus_names_.shrink_to_fit();
 	}
 
-	void TransportCatalogue::AddBusToStops(const Bus& bus) {
-		for (auto stop : bus.stops) {
-			stop_to_buses_[stop].insert(&bus);
+	std::optional<uint32_t> TransportCatalogue::FindDistance(StopId from, StopId to) const {
+		// Строка упорядочена по остановке назначения и обычно содержит лишь несколько соседей
+		const auto first = distance_to_.begin() + distance_begin_[from];
+		const auto last = distance_to_.begin() + distance_begin_[from + 1];
+		const auto it = std::lower_bound(first, last, to);
+		if (it != last && *it == to) {
+			return distance_values_[it - distance_to_.begin()];
 		}
+		return std::nullopt;
 	}
 
-	double TransportCatalogue::ComputeDistance(const Stop* from, const Stop* to, DistanceType type) const {
-		if (type == DistanceType::FACT) {
-			auto it = stops_to_distance_.find({ from, to });
-			if (it != stops_to_distance_.end()) {
-				return it->second;
-			}
+	void TransportCatalogue::BuildDistanceRows() {
+		// Устойчивая сортировка оставляет первым из повторяющихся расстояний добавленное раньше
+		std::stable_sort(distance_edges_.begin(), distance_edges_.end(), [](const DistanceEdge& lhs, const DistanceEdge& rhs) {
+			return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+		});
 
-			it = stops_to_distance_.find({ to, from });
-			if (it != stops_to_distance_.end()) {
-				return it->second;
+		distance_begin_.assign(stop_coordinates_.size() + 1, 0);
+		distance_to_.reserve(distance_edges_.size());
+		distance_values_.reserve(distance_edges_.size());
+		for (size_t i = 0; i < distance_edges_.size(); ++i) {
+			const DistanceEdge& edge = distance_edges_[i];
+			if (i > 0 && edge.from == distance_edges_[i - 1].from && edge.to == distance_edges_[i - 1].to) {
+				continue;
 			}
+			++distance_begin_[edge.from + 1];
+			distance_to_.push_back(edge.to);
+			distance_values_.push_back(edge.distance);
+		}
+		for (size_t from = 0; from + 1 < distance_begin_.size(); ++from) {
+			distance_begin_[from + 1] += distance_begin_[from];
 		}
+		distance_edges_ = {};
+	}
 
-		return geo::ComputeDistance(from->coordinates, to->coordinates);
+	// Возвращает расстояния из строк в список, чтобы к ним можно было добавлять новые
+	void TransportCatalogue::ReleaseDistanceRows() {
+		distance_edges_.reserve(distance_to_.size());
+		for (StopId from = 0; from + 1 < distance_begin_.size(); ++from) {
+			for (uint32_t i = distance_begin_[from]; i < distance_begin_[from + 1]; ++i) {
+				distance_edges_.push_back(DistanceEdge{ from, distance_to_[i], distance_values_[i] });
+			}
+		}
+		distance_begin_ = {};
+		distance_to_ = {};
+		distance_values_ = {};
 	}
 
 } // namespace tc
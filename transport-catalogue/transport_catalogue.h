@@ -1,55 +1,146 @@
 #pragma once
 
+#include <cstdint>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <optional>
-#include <set>
 #include <string>
 #include <string_view>
 #include <unordered_map>
-#include <utility>
 #include <vector>
 
 #include "domain.h"
+#include "name_index.h"
+#include "string_pool.h"
+#include "thread_pool.h"
 
 namespace tc {
 
-		class TransportCatalogue {
-			struct StopsHasher {
-				size_t operator() (const std::pair<const Stop*, const Stop*>& stops) const;
-			};
+		// Идентификатор названия остановки. Выдаётся и для остановок, которые ещё не добавлены,
+		// поэтому на остановку можно сослаться до её добавления. Идентификаторы идут подряд с нуля
+		using StopId = util::StringPool::Id;
+		// Номер маршрута в порядке добавления
+		using BusId = uint32_t;
 
-			struct SetOfBusesCmp {
-				bool operator() (const Bus* lhs, const Bus* rhs) const;
-			};
-			using SetOfBuses = std::set<const Bus*, SetOfBusesCmp>;
+		/*
+		 * Маршруты справочника в виде структур Bus, ссылающихся на структуры Stop, для кода,
+		 * которому удобнее работать с указателями (MapRenderer). Представление хранит копии данных
+		 * и не зависит от справочника после создания
+		 */
+		class BusesView {
+		public:
+			const std::vector<const Bus*>& GetBuses() const {
+				return bus_pointers_;
+			}
+
+		private:
+			friend class TransportCatalogue;
 
+			std::deque<Stop> stops_;
+			std::deque<Bus> buses_;
+			std::vector<const Bus*> bus_pointers_;
+		};
+
+		/*
+		 * Данные остановок и маршрутов хранятся в параллельных массивах, индексами которых служат
+		 * идентификаторы остановок и номера маршрутов. Остановки маршрутов всех маршрутов лежат
+		 * подряд в одном массиве, поэтому обход маршрута не переходит по указателям
+		 */
+		class TransportCatalogue {
 			enum class DistanceType {
 				GEO,
 				FACT
 			};
 
 		public:
-			void AddStop(std::string name, geo::Coordinates coordinates);
-			void AddDistance(const std::string& from, const std::string& to, uint32_t distance);
+			// Способ подготовки сведений о маршрутах в Finalize
+			enum class BusInfoMode {
+				// Сведения обо всех маршрутах вычисляются сразу
+				EAGER,
+				// Сведения о маршруте вычисляются при первом запросе и сохраняются
+				LAZY
+			};
+
+			StopId GetStopId(std::string_view name);
+
+			void AddStop(StopId id, geo::Coordinates coordinates);
+			void AddDistance(StopId from, StopId to, uint32_t distance);
+			void AddBus(std::string name, bool ring, const std::vector<StopId>& stop_ids);
+			bool HasStop(StopId id) const;
+
+			void AddStop(std::string_view name, geo::Coordinates coordinates);
+			void AddDistance(std::string_view from, std::string_view to, uint32_t distance);
 			void AddBus(std::string name, bool ring, const std::vector<std::string>& stop_names);
-			
-			std::vector<const Bus*> GetBuses() const;
+			bool HasStop(std::string_view name) const;
+
+			// Подготавливает таблицу сведений о маршрутах, после чего GetBusInfo не вычисляет их повторно,
+			// строит индексы названий остановок и маршрутов для поиска и списки маршрутов через остановки.
+			// В режиме EAGER таблица заполняется в пуле потоков, если он задан. Запросы к подготовленному
+			// справочнику можно выполнять из нескольких потоков. Изменение справочника отменяет подготовку
+			void Finalize(BusInfoMode mode = BusInfoMode::EAGER, util::ThreadPool* thread_pool = nullptr);
+
+			BusesView GetBusesView() const;
+			// Сведения об остановках и маршрутах доступны только в подготовленном справочнике
 			std::optional<StopInfo> GetStopInfo(const std::string& name) const;
-			std::optional<BusInfo> GetBusInfo(const std::string& name) const;			
+			std::optional<BusInfo> GetBusInfo(const std::string& name) const;
 
 		private:
-			std::deque<Stop> stops_;
-			std::deque<Bus> buses_;
+			// ----- Остановки, индекс - StopId -----
+			util::StringPool stop_names_;
+			std::vector<geo::Coordinates> stop_coordinates_;
+			// Остановки, на которые только ссылаются, ещё не добавлены
+			std::vector<bool> stop_added_;
+
+			// ----- Маршруты, индекс - BusId -----
+			std::deque<std::string> bus_names_;
+			std::vector<bool> bus_ring_;
+			// Остановки маршрута i занимают в bus_stops_ участок [bus_stops_begin_[i], bus_stops_begin_[i + 1])
+			std::vector<uint32_t> bus_stops_begin_{ 0 };
+			std::vector<StopId> bus_stops_;
+			// При повторяющихся названиях находится первый маршрут. После подготовки справочника
+			// заменяется индексом bus_index_ и освобождается
+			std::unordered_map<std::string_view, BusId> name_to_bus_;
+
+			// ----- Расстояния по дорогам -----
+			struct DistanceEdge {
+				StopId from;
+				StopId to;
+				uint32_t distance;
+			};
+
+			// Расстояния в порядке добавления. При подготовке справочника переносятся в строки distance_*,
+			// из повторно заданных расстояний между парой остановок сохраняется первое
+			std::vector<DistanceEdge> distance_edges_;
+			// Расстояния от остановки from занимают участок [distance_begin_[from], distance_begin_[from + 1])
+			// массивов distance_to_ (упорядочен по возрастанию) и distance_values_
+			std::vector<uint32_t> distance_begin_;
+			std::vector<StopId> distance_to_;
+			std::vector<uint32_t> distance_values_;
 
-			std::unordered_map<std::string_view, const Stop*> name_to_stop_;
-			std::unordered_map<std::string_view, const Bus*> name_to_bus_;
-			std::unordered_map<const Stop*, SetOfBuses> stop_to_buses_;
-			std::unordered_map<std::pair<const Stop*, const Stop*>, uint32_t, StopsHasher> stops_to_distance_;
+			// ----- Подготовленный справочник -----
+			bool finalized_ = false;
+			// Индексы добавленных остановок и маршрутов по названию
+			util::NameIndex stop_index_;
+			util::NameIndex bus_index_;
+			// Названия маршрутов через остановку stop занимают участок [stop_buses_begin_[stop], stop_buses_begin_[stop + 1])
+			// массива stop_bus_names_, упорядочены и не повторяются
+			std::vector<uint32_t> stop_buses_begin_;
+			std::vector<std::string_view> stop_bus_names_;
+			// Сведения о маршрутах, индекс - BusId. В режиме LAZY элемент заполняется
+			// при первом запросе под своим флагом
+			mutable std::vector<BusInfo> bus_infos_;
+			std::unique_ptr<std::once_flag[]> bus_info_flags_;
 
-			const Stop* FindStop(const std::string& name) const;
-			const Bus* FindBus(const std::string& name) const;
-			void AddBusToStops(const Bus& bus);
-			double ComputeDistance(const Stop* from, const Stop* to, DistanceType type) const;
+			std::optional<StopId> FindStop(std::string_view name) const;
+			std::optional<BusId> FindBus(std::string_view name) const;
+			double ComputeDistance(StopId from, StopId to, DistanceType type) const;
+			std::optional<uint32_t> FindDistance(StopId from, StopId to) const;
+			void BuildStopBuses();
+			void BuildDistanceRows();
+			void ReleaseDistanceRows();
+			BusInfo ComputeBusInfo(BusId bus) const;
+			void ResetFinalize();
 		};
 
 } // namespace tc